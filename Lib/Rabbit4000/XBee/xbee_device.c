@@ -33,6 +33,14 @@
 	#define _xbee_device_debug __nodebug
 #endif
 
+// Timing probes (PROBE.LIB) are only available on Rabbit targets.
+#ifdef __DC__
+	#use "probe.lib"
+#elif ! defined PROBE_ENTER
+	#define PROBE_ENTER(p, name)
+	#define PROBE_EXIT(p)
+#endif
+
 // Load library for sending and receiving frames over serial port.
 #include "xbee/serial.h"
 #include "wpan/aps.h"
@@ -296,6 +304,10 @@ RETURNS:  >=0      - Number of frames received and dispatched.
 
 
 **************************************************************************/
+#ifdef PROBE_ENABLE
+Probe _probe_xbee_dev_tick;
+#endif
+
 _xbee_device_debug
 int xbee_dev_tick( xbee_dev_t *xbee)
 {
@@ -321,7 +333,9 @@ int xbee_dev_tick( xbee_dev_t *xbee)
 
 	INTERRUPT_ENABLE;
 
+	PROBE_ENTER( _probe_xbee_dev_tick, "xbee_dev_tick");
 	frames = _xbee_frame_load( xbee);
+	PROBE_EXIT( _probe_xbee_dev_tick);
 	xbee->flags &= ~XBEE_DEV_FLAG_IN_TICK;
 
 	return frames;
@@ -0,0 +1,403 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/*************************************************************************
+
+	Samples\Crypto\crypto_kernels.c
+
+	Known-answer tests and throughput benchmark for the core cryptographic
+	kernels: AES (AES_CORE.LIB), SHA-1 (SHA1.LIB), SHA-256 (SHA2.LIB),
+	MD5 (MD5.LIB) and modular exponentiation (MPARITH.LIB).
+
+	Set CRYPTO_PORTABLE_C below to 1 to run the portable C reference
+	kernels instead of the assembly language versions.  Both builds must
+	pass all of the known-answer tests, and must print the same fingerprint
+	at the end (a SHA-1 digest of every benchmark output).  Comparing the
+	timing figures of the two builds shows what the assembly code buys.
+
+	Test vectors are from FIPS-197 (AES), NIST SP 800-38A (AES-CBC),
+	FIPS 180-2 (SHA-1, SHA-256) and RFC 1321 (MD5).  Modular exponentiation
+	is checked with Fermat's little theorem (2^(p-1) mod p == 1) using the
+	known primes 2^64-59 and the NIST P-256 field prime.
+
+	Each benchmark is repeated from the start until it has run for
+	BENCH_MS milliseconds, so that the timer's resolution doesn't matter,
+	and its output is the same however many times it ran.  Throughput is
+	also given in bytes per CPU cycle, using the clock speed estimated from
+	freq_divider in the same way as Samples\fp_benchmark.c.
+
+	The host simulation build (Utilities/HostSim) compiles this sample
+	with the portable C kernels, so its fingerprint can be compared with
+	that of the assembly build on a target.
+
+*************************************************************************/
+
+// Set to 1 to test the portable C kernels
+#ifndef CRYPTO_PORTABLE_C
+	#define CRYPTO_PORTABLE_C 0
+#endif
+
+#use "mparith.lib"
+#use "aes_core.lib"
+#use "sha1.lib"
+#use "sha2.lib"
+#use "md5.lib"
+
+// Benchmark buffer size and number of passes over it for each kernel
+#define BENCH_LEN		2048
+#define BENCH_REPS	16
+
+// Bit length of the random modulus for the modular exponentiation benchmark
+#define BENCH_MP_BITS	512
+
+// Shortest time (ms) for which each benchmark is run
+#ifndef BENCH_MS
+	#define BENCH_MS		1000
+#endif
+
+char bench_in[BENCH_LEN];
+char bench_out[BENCH_LEN];
+float mhz;
+sha_state fingerprint;
+int failures;
+
+// Deterministic filler, so that every build benchmarks identical data
+unsigned long lcg_seed;
+void lcg_fill(char *p, word len)
+{
+	while (len--) {
+		lcg_seed = lcg_seed * 1103515245uL + 12345uL;
+		*p++ = (char)(lcg_seed >> 16);
+	}
+}
+
+// Convert hex string into bytes; returns number of bytes
+int hex2bytes(const char *hex, char *out)
+{
+	int n;
+	unsigned b;
+
+	for (n = 0; *hex && hex[1]; hex += 2, ++n) {
+		sscanf(hex, "%2x", &b);
+		out[n] = (char)b;
+	}
+	return n;
+}
+
+void check(const char *name, const char __far *got, const char *expect_hex)
+{
+	char expect[64];
+	int len, i;
+
+	len = hex2bytes(expect_hex, expect);
+	printf("%-28s ", name);
+	for (i = 0; i < len; ++i)
+		if (got[i] != expect[i])
+			break;
+	if (i == len) {
+		printf("passed.\n");
+		return;
+	}
+	++failures;
+	printf("failed!\n  expected: %s\ncalculated: ", expect_hex);
+	for (i = 0; i < len; ++i)
+		printf("%02x", (byte)got[i]);
+	printf("\n");
+}
+
+// Print the results of a benchmark which processed 'runs' times
+// BENCH_REPS * BENCH_LEN bytes in 'ms' milliseconds.
+void report(const char *name, unsigned long ms, unsigned long runs)
+{
+	unsigned long bytes;
+
+	if (!ms)
+		ms = 1;
+	bytes = runs * BENCH_REPS * (unsigned long)BENCH_LEN;
+	printf("%-16s %9lu bytes %6lu ms %9.1f kB/s", name, bytes, ms,
+		(float)bytes / (float)ms);
+	if (mhz > 0)
+		printf(" %9.5f bytes/cycle", (float)bytes / ((float)ms * 1000.0 * mhz));
+	printf("\n");
+}
+
+/*
+ * Known-answer tests
+ */
+
+void test_aes(void)
+{
+	AESstreamState aes;
+	char key[16], iv[16], pt[64], ct[64];
+
+	// FIPS-197 appendix C.1
+	hex2bytes("000102030405060708090a0b0c0d0e0f", key);
+	hex2bytes("00112233445566778899aabbccddeeff", pt);
+	AESexpandKey4(aes.expanded_key, key);
+	AESencrypt4x4(aes.expanded_key, pt, ct);
+	check("AES-128 encrypt", ct, "69c4e0d86a7b0430d8cdb78070b4c55a");
+	AESdecrypt4x4(aes.expanded_key, ct, ct);
+	check("AES-128 decrypt", ct, "00112233445566778899aabbccddeeff");
+
+	// SP 800-38A F.2.1 and F.2.2
+	hex2bytes("2b7e151628aed2a6abf7158809cf4f3c", key);
+	hex2bytes("000102030405060708090a0b0c0d0e0f", iv);
+	hex2bytes("6bc1bee22e409f96e93d7e117393172a"
+	          "ae2d8a571e03ac9c9eb76fac45af8e51"
+	          "30c81c46a35ce411e5fbc1191a0a52ef"
+	          "f69f2445df4f9b17ad2b417be66c3710", pt);
+	AESinitStream4x4(&aes, key, iv);
+	AESencryptStream4xK_CBC(&aes, pt, ct, 64);
+	check("AES-128-CBC encrypt", ct,
+		"7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+		"73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+	AESinitStream4x4(&aes, NULL, iv);
+	AESdecryptStream4xK_CBC(&aes, ct, ct, 64);
+	check("AES-128-CBC decrypt", ct,
+		"6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+}
+
+const char *hash_msg[] =
+{
+	"abc",
+	"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	"message digest",
+	"12345678901234567890123456789012345678901234567890123456789012345678901234567890"
+};
+
+void test_hashes(void)
+{
+	sha_state sha1;
+	sha256_context sha256;
+	md5_state_t md5;
+	char digest[32];
+	int i;
+
+	// FIPS 180-2 appendix A and B
+	for (i = 0; i < 2; ++i) {
+		sha_init(&sha1);
+		sha_add(&sha1, hash_msg[i], strlen(hash_msg[i]));
+		sha_finish(&sha1, digest);
+		check(i ? "SHA-1 (448 bits)" : "SHA-1 (abc)", digest, i ?
+			"84983e441c3bd26ebaae4aa1f95129e5e54670f1" :
+			"a9993e364706816aba3e25717850c26c9cd0d89d");
+
+		sha256_init(&sha256);
+		sha256_add(&sha256, hash_msg[i], strlen(hash_msg[i]));
+		sha256_finish(&sha256, digest);
+		check(i ? "SHA-256 (448 bits)" : "SHA-256 (abc)", digest, i ?
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" :
+			"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	}
+
+	// RFC 1321 appendix A.5
+	md5_init(&md5);
+	md5_append(&md5, hash_msg[0], strlen(hash_msg[0]));
+	md5_finish(&md5, digest);
+	check("MD5 (abc)", digest, "900150983cd24fb0d6963f7d28e17f72");
+	md5_init(&md5);
+	md5_append(&md5, hash_msg[2], strlen(hash_msg[2]));
+	md5_finish(&md5, digest);
+	check("MD5 (message digest)", digest, "f96b697d7cb7938d525a2f31aaf161d0");
+	md5_init(&md5);
+	md5_append(&md5, hash_msg[3], strlen(hash_msg[3]));
+	md5_finish(&md5, digest);
+	check("MD5 (80 digits)", digest, "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+// Check 2^(p-1) mod p == 1, for prime p given as big-endian hex
+void test_fermat(const char *name, const char *prime_hex)
+{
+	MP_Mod m;
+	char pbin[MP_SIZE], g[MP_SIZE], e[MP_SIZE], b[MP_SIZE];
+	int len;
+
+	len = hex2bytes(prime_hex, pbin);
+	m.length = len + 2;
+	bin2mp(pbin, &m, len);
+	mp_setup_mrecip2(&m);
+
+	memset(g, 0, sizeof(g));
+	g[0] = 2;
+	memcpy(e, m.mod, m.length);
+	e[0] -= 1;								// p is odd, so no borrow
+	mp_modexp(b, g, e, &m);
+
+	// Expect b == 1, i.e. 01 followed by zero bytes
+	memset(e, 0, m.length);
+	e[0] = 1;
+	printf("%-28s ", name);
+	if (memcmp(b, e, m.length)) {
+		++failures;
+		printf("failed!\n");
+	}
+	else
+		printf("passed.\n");
+}
+
+/*
+ * Benchmarks.  Each result is also added to the fingerprint.
+ */
+
+void bench_aes(void)
+{
+	AESstreamState aes;
+	char key[16];
+	unsigned long t, runs;
+	int i;
+
+	lcg_fill(key, 16);
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		AESinitStream4x4(&aes, key, key);
+		for (i = 0; i < BENCH_REPS; ++i)
+			AESencryptStream4xK_CBC(&aes, bench_in, bench_out, BENCH_LEN);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	report("AES-128-CBC enc", MS_TIMER - t, runs);
+	sha_add(&fingerprint, bench_out, BENCH_LEN);
+
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		AESinitStream4x4(&aes, NULL, key);
+		for (i = 0; i < BENCH_REPS; ++i)
+			AESdecryptStream4xK_CBC(&aes, bench_in, bench_out, BENCH_LEN);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	report("AES-128-CBC dec", MS_TIMER - t, runs);
+	sha_add(&fingerprint, bench_out, BENCH_LEN);
+}
+
+void bench_hashes(void)
+{
+	sha_state sha1;
+	sha256_context sha256;
+	md5_state_t md5;
+	char digest[32];
+	unsigned long t, runs;
+	int i;
+
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		sha_init(&sha1);
+		for (i = 0; i < BENCH_REPS; ++i)
+			sha_add(&sha1, bench_in, BENCH_LEN);
+		sha_finish(&sha1, digest);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	report("SHA-1", MS_TIMER - t, runs);
+	sha_add(&fingerprint, digest, 20);
+
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		sha256_init(&sha256);
+		for (i = 0; i < BENCH_REPS; ++i)
+			sha256_add(&sha256, bench_in, BENCH_LEN);
+		sha256_finish(&sha256, digest);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	report("SHA-256", MS_TIMER - t, runs);
+	sha_add(&fingerprint, digest, 32);
+
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		md5_init(&md5);
+		for (i = 0; i < BENCH_REPS; ++i)
+			md5_append(&md5, bench_in, BENCH_LEN);
+		md5_finish(&md5, digest);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	report("MD5", MS_TIMER - t, runs);
+	sha_add(&fingerprint, digest, 16);
+}
+
+void bench_modexp(void)
+{
+	MP_Mod m;
+	char g[MP_SIZE], e[MP_SIZE], b[MP_SIZE];
+	unsigned long t, runs;
+	float ms;
+	word len;
+
+	len = BENCH_MP_BITS / 8;
+	m.length = len + 2;
+	lcg_fill(m.mod, len);
+	m.mod[len-1] |= 0x80;
+	m.mod[len] = m.mod[len+1] = 0;
+	mp_setup_mrecip2(&m);
+	memset(g, 0, sizeof(g));
+	lcg_fill(g, len - 1);
+	memset(e, 0, sizeof(e));
+	lcg_fill(e, len);
+
+	t = MS_TIMER;
+	runs = 0;
+	do {
+		mp_modexp(b, g, e, &m);
+		++runs;
+	} while (MS_TIMER - t < BENCH_MS);
+	ms = (float)(MS_TIMER - t) / (float)runs;
+	printf("%-16s %9u bits  %9.3f ms", "modexp", BENCH_MP_BITS, ms);
+	if (mhz > 0)
+		printf(" %14.0f cycles", ms * 1000.0 * mhz);
+	printf("\n");
+	sha_add(&fingerprint, b, len);
+}
+
+int main()
+{
+	char digest[20];
+	int i;
+
+	//  Clock speed in MHz; see Samples\fp_benchmark.c
+	mhz = 19200. * 32. * (float)freq_divider / 1000000.;
+
+	printf("Crypto kernel tests (%s), ",
+		CRYPTO_PORTABLE_C ? "portable C" : "assembly");
+	if (mhz > 0)
+		printf("CPU clock %.2f MHz\n\n", mhz);
+	else
+		printf("CPU clock unknown\n\n");
+
+	failures = 0;
+	test_aes();
+	test_hashes();
+	test_fermat("modexp (p = 2^64-59)", "ffffffffffffffc5");
+	test_fermat("modexp (p = P-256 prime)",
+		"ffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+
+	printf("\nBenchmarks (%u passes over %u bytes, repeated for %u ms):\n\n",
+		BENCH_REPS, BENCH_LEN, BENCH_MS);
+	lcg_seed = 1;
+	lcg_fill(bench_in, BENCH_LEN);
+	sha_init(&fingerprint);
+	bench_aes();
+	bench_hashes();
+	bench_modexp();
+
+	sha_finish(&fingerprint, digest);
+	printf("\nFingerprint (must match between builds): ");
+	for (i = 0; i < 20; ++i)
+		printf("%02x", (byte)digest[i]);
+	printf("\n\n%d test(s) failed.\n", failures);
+
+	return failures;
+}
@@ -0,0 +1,125 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	cbuf_sim.c
+
+	C versions of the assembly functions of CBUF.LIB, for the host
+	simulation build.  The C functions of CBUF.LIB (buffer_init and the
+	span functions) are compiled from the library itself.  Like the
+	assembly, buffer_put and buffer_get copy in at most two blocks.
+
+	These are written from the function descriptions in CBUF.LIB, which
+	hostbench's spec test checks them against.  Passing that test says
+	nothing about the assembly, which is only tested on a Rabbit (see
+	Samples/CBUF_SPANS.C).  A change to the assembly must be made here
+	too.
+
+***************************************************************************/
+
+int buffer_getch(cbuf_t __far * buf)
+{
+	auto int ch;
+
+	if (buf->head == buf->tail)
+		return -1;
+	ch = buf->buffer[buf->head];
+	buf->head = (buf->head + 1) & buf->mask;
+	return ch;
+}
+
+int buffer_putch(cbuf_t __far * buf, int ch)
+{
+	if (((buf->tail + 1) & buf->mask) == buf->head)
+		return 0;
+	buf->buffer[buf->tail] = ch;
+	buf->tail = (buf->tail + 1) & buf->mask;
+	return 1;
+}
+
+int buffer_peek(cbuf_t __far * buf)
+{
+	return buf->head == buf->tail ? -1 : buf->buffer[buf->head];
+}
+
+int buffer_wrlock(cbuf_t __far * buf)
+{
+	if (!buf || buf->lock & (1 << CBUF_WRITE_BIT))
+		return 0;
+	buf->lock |= 1 << CBUF_WRITE_BIT;
+	return 1;
+}
+
+void buffer_wrunlock(cbuf_t __far * buf)
+{
+	buf->lock &= ~(1 << CBUF_WRITE_BIT);
+}
+
+int buffer_rdlock(cbuf_t __far * buf)
+{
+	if (!buf || buf->lock & (1 << CBUF_READ_BIT))
+		return 0;
+	buf->lock |= 1 << CBUF_READ_BIT;
+	return 1;
+}
+
+void buffer_rdunlock(cbuf_t __far * buf)
+{
+	buf->lock &= ~(1 << CBUF_READ_BIT);
+}
+
+int buffer_length(cbuf_t __far * buf)
+{
+	return buf->mask;
+}
+
+int buffer_used(cbuf_t __far * buf)
+{
+	return (buf->tail - buf->head) & buf->mask;
+}
+
+int buffer_free(cbuf_t __far * buf)
+{
+	return (buf->head - buf->tail - 1) & buf->mask;
+}
+
+void buffer_flush(cbuf_t __far * buf)
+{
+	buf->head = buf->tail;
+}
+
+int buffer_put(cbuf_t __far * buf, const byte __far * source, int length)
+{
+	auto word n, first;
+
+	n = u_min(length, buffer_free(buf));
+	first = u_min(n, buf->mask + 1 - buf->tail);
+	_f_memcpy(buf->buffer + buf->tail, source, first);
+	_f_memcpy(buf->buffer, source + first, n - first);
+	buf->tail = (buf->tail + n) & buf->mask;
+	return n;
+}
+
+int buffer_get(cbuf_t __far * buf, byte __far * dest, int length)
+{
+	auto word n, first;
+
+	n = u_min(length, buffer_used(buf));
+	first = u_min(n, buf->mask + 1 - buf->head);
+	_f_memcpy(dest, buf->buffer + buf->head, first);
+	_f_memcpy(dest + first, buf->buffer, n - first);
+	buf->head = (buf->head + n) & buf->mask;
+	return n;
+}
@@ -0,0 +1,76 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	crypto_sim.c
+
+	Stand-ins for the functions and variables from outside the crypto
+	libraries which they and CRYPTO_KERNELS.c use, for the host simulation
+	build.  numhexstr2bin is a C copy of the one in STRING.LIB, which is
+	not built for the host.
+
+***************************************************************************/
+
+#if defined __x86_64__ || defined __i386__
+// On the target, freq_divider is set by the BIOS from the CPU clock, in
+// units of 19200 * 32 Hz (see Samples\fp_benchmark.c).  Here it is the
+// rate of the time-stamp counter, measured against CLOCK_MONOTONIC over
+// 100 ms, so the sample's cycles are time-stamp counter ticks.
+static int _cs_freq_divider(void)
+{
+	auto struct timespec t0, t1;
+	auto uint64_t c0;
+	auto double s;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	c0 = __builtin_ia32_rdtsc();
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	} while (s < 0.1);
+	return (int)((__builtin_ia32_rdtsc() - c0) / s / (19200.0 * 32.0) + 0.5);
+}
+#define freq_divider	_cs_freq_divider()
+#else
+// No cycle counter, so the sample leaves out the cycle figures.
+#define freq_divider	0
+#endif
+
+word numhexstr2bin(const char __far * p, char __far * bin, word bin_len)
+{
+	auto const char __far * q;
+	auto word plen;
+	auto word retval;
+	auto unsigned b;
+
+	// Scan to end
+	for (q = p; isxdigit((byte)*q); ++q);
+	retval = plen = (word)(q - p);
+	// Fill in by pairs of digits, then the odd digit left over
+	while (plen >= 2 && bin_len) {
+		q -= 2;
+		sscanf(q, "%2x", &b);
+		*bin++ = b;
+		plen -= 2;
+		--bin_len;
+	}
+	if (plen && bin_len) {
+		sscanf(q - 1, "%1x", &b);
+		*bin++ = b;
+		--bin_len;
+	}
+	memset(bin, 0, bin_len);
+	return retval;
+}
@@ -0,0 +1,294 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	dcsim.h
+
+	Dynamic C portability shim for the host simulation build (see
+	README.txt).  The Makefile strips the #asm blocks and #use lines out
+	of each library, then compiles the rest with this header included
+	first.  Everything is one flat address space, so far and xmem
+	pointers are ordinary pointers, and an xmem address (long) is just a
+	pointer cast to long (see also DCSIM_LONG32 below).
+
+***************************************************************************/
+#ifndef DCSIM_H
+#define DCSIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <assert.h>
+
+#ifdef DCSIM_LONG32
+/* A long is 32 bits in Dynamic C, and some libraries depend on it (e.g. the
+   crypto kernels use unsigned long for 32-bit words, and rely on it
+   wrapping, and the FAT libraries use it in on-disk structures).  A
+   program can define DCSIM_LONG32 to make long an alias for int.  The l
+   modifiers are removed from printf formats to match.
+
+   Such a program can only use the xmem functions below if the addresses
+   of its data fit in 31 bits.  That is so for its static data and heap if
+   it is linked with -no-pie and runs under dcsim_run(), which also keeps
+   malloc() from using mmap(), and runs it on a stack in its static data.
+   Taking the xmem address of anything else makes _dcsim_addr() abort. */
+#include <malloc.h>
+#include <ucontext.h>
+
+static int (* _dcsim_main)(void);
+static int _dcsim_rc;
+
+static inline void _dcsim_start(void)
+{
+	_dcsim_rc = _dcsim_main();
+}
+
+// Run fn, as above, and return its result.
+static inline int dcsim_run(int (* fn)(void))
+{
+	static char stack[1 << 20];
+	static ucontext_t caller, ctx;
+
+	mallopt(M_MMAP_MAX, 0);
+	_dcsim_main = fn;
+	getcontext(&ctx);
+	ctx.uc_stack.ss_sp = stack;
+	ctx.uc_stack.ss_size = sizeof(stack);
+	ctx.uc_link = &caller;
+	makecontext(&ctx, _dcsim_start, 0);
+	swapcontext(&caller, &ctx);
+	return _dcsim_rc;
+}
+
+static inline const char * _dcsim_fmt(const char * fmt, char * buf, int size)
+{
+	int conv;
+
+	for (conv = 0; *fmt && size > 1; ++fmt) {
+		if (conv && *fmt == 'l')
+			continue;
+		if (*fmt == '%')
+			conv = !conv;
+		else if (conv && isalpha((unsigned char)*fmt))
+			conv = 0;
+		*buf++ = *fmt;
+		--size;
+	}
+	*buf = 0;
+	return buf;
+}
+
+static inline int _dcsim_printf(const char * fmt, ...)
+{
+	char f[256];
+	va_list ap;
+	int n;
+
+	_dcsim_fmt(fmt, f, sizeof(f));
+	va_start(ap, fmt);
+	n = vprintf(f, ap);
+	va_end(ap);
+	return n;
+}
+
+static inline int _dcsim_sprintf(char * s, const char * fmt, ...)
+{
+	char f[256];
+	va_list ap;
+	int n;
+
+	_dcsim_fmt(fmt, f, sizeof(f));
+	va_start(ap, fmt);
+	n = vsprintf(s, f, ap);
+	va_end(ap);
+	return n;
+}
+
+#define long		int
+#define printf		_dcsim_printf
+#define sprintf	_dcsim_sprintf
+#endif
+
+#define _DCSIM_
+#define CC_VER			0xA72			// Dynamic C 10.72
+
+/* Types from the Dynamic C runtime (see StdBios.c) */
+typedef unsigned char	byte;
+typedef unsigned short	word;
+typedef unsigned int		longword;
+typedef unsigned char	uint8;
+typedef unsigned short	uint16;
+typedef short				int16;
+typedef unsigned int		uint32;
+typedef int					int32;
+
+/* Storage classes and qualifiers */
+#define __far
+#define __near
+#define __xmem
+#define __root
+#define __nodebug
+#define __debug
+#define __nouseix
+#define far
+#define nodebug
+#define root
+#define xmem
+
+/* Far versions of the string functions */
+#define _f_memcpy		memcpy
+#define _f_memmove	memmove
+#define _f_memset		memset
+#define _f_memcmp		memcmp
+#define _f_memchr		memchr
+#define _f_strlen		strlen
+#define _f_strcpy		strcpy
+#define _f_strcat		strcat
+#define _f_strchr		strchr
+#define _f_strtol		strtol
+#define _n_strchr		strchr
+
+static inline unsigned u_min(unsigned a, unsigned b) { return a < b ? a : b; }
+static inline unsigned u_max(unsigned a, unsigned b) { return a > b ? a : b; }
+static inline int i_min(int a, int b) { return a < b ? a : b; }
+static inline int i_max(int a, int b) { return a > b ? a : b; }
+
+// Byte order reversal (see MATH.LIB)
+static inline uint16_t intel16(uint16_t x) { return __builtin_bswap16(x); }
+static inline uint32_t intel(uint32_t x) { return __builtin_bswap32(x); }
+
+/* Heaps */
+#define _sys_malloc	malloc
+#define _sys_free		free
+
+/* Extended memory.  _dcsim_ptr() converts an xmem address back to a
+   pointer. */
+#define XALLOC_ANY		0			// _xalloc() memory types (see STACK.LIB)
+#define XALLOC_BB			1
+#define XALLOC_NOTBB		2
+#define XALLOC_MAYBBB	3
+#define XALLOC_URAM		4
+
+#define _dcsim_ptr(addr)	((void *)(uintptr_t)(unsigned long)(addr))
+
+static inline long _dcsim_addr(const void * p)
+{
+#ifdef DCSIM_LONG32
+	if ((uintptr_t)p >> 31) {
+		fprintf(stderr, "address %p does not fit in a long\n", p);
+		abort();
+	}
+#endif
+	return (long)(uintptr_t)p;
+}
+static inline long xalloc(long len) { return _dcsim_addr(malloc(len)); }
+static inline long paddr(const void * p) { return _dcsim_addr(p); }
+
+// Allocate *size bytes, aligned to a 2^align boundary.  The type is
+// ignored.
+static inline long _xalloc(long * size, word align, word type)
+{
+	void * p;
+
+	if (posix_memalign(&p, 1L << align < sizeof(void *) ? sizeof(void *) :
+	                   1L << align, *size)) {
+		fprintf(stderr, "_xalloc failed\n");
+		abort();
+	}
+	return _dcsim_addr(p);
+}
+static inline int root2xmem(long dest, const void * src, unsigned len)
+{
+	memcpy(_dcsim_ptr(dest), src, len);
+	return 0;
+}
+static inline int xmem2root(void * dest, long src, unsigned len)
+{
+	memcpy(dest, _dcsim_ptr(src), len);
+	return 0;
+}
+static inline int xmem2xmem(long dest, long src, unsigned len)
+{
+	memmove(_dcsim_ptr(dest), _dcsim_ptr(src), len);
+	return 0;
+}
+static inline long xgetlong(long src) { return *(long *)_dcsim_ptr(src); }
+static inline void xsetlong(long dest, long value)
+{
+	*(long *)_dcsim_ptr(dest) = value;
+}
+
+/* Timers, from the host's monotonic clock */
+static inline unsigned long _dcsim_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+#define MS_TIMER		_dcsim_ms()
+#define SEC_TIMER		(_dcsim_ms() / 1000)
+#define TICK_TIMER	(_dcsim_ms() * 1024 / 1000)
+#define PROBE_TICKS	1000000L			// probe_now() rate (see probe_sim.c)
+
+// Time-outs (see STDVDRIVER.LIB)
+#define _SET_TIMEOUT(x)			(MS_TIMER + (x))
+#define _CHK_TIMEOUT(x)			chk_timeout(x)
+#define _SET_SHORT_TIMEOUT(x)	((uint16_t)MS_TIMER + (x))
+#define _CHK_SHORT_TIMEOUT(x)	((int16_t)((uint16_t)MS_TIMER - (x)) >= 0)
+static inline int chk_timeout(uint32_t timeout)
+{
+	return (int32_t)((uint32_t)MS_TIMER - timeout) >= 0;
+}
+static inline uint32_t set_timeout(unsigned seconds)
+{
+	return _SET_TIMEOUT(seconds * 1000);
+}
+
+/* The simulation is single threaded, as without uC/OS (see NET.LIB), and
+   has no system mode (see DEFAULT.H) */
+#define _system
+#define _SYS_CALL_VARS
+#define _NET_SYSCALL(x)
+#define LOCK_GLOBAL(l)
+#define UNLOCK_GLOBAL(l)
+#define LOCK_GLOBAL_IF_INIT(l)
+#define UNLOCK_GLOBAL_IF_INIT(l)
+
+static inline void exception(int code)
+{
+	fprintf(stderr, "exception %d\n", code);
+	abort();
+}
+
+#ifndef DCSIM_NET
+/* Packet buffers (IP.LIB) are only simulated in a program which defines
+   DCSIM_NET (see net_sim.c).  In others, library functions which use them
+   are compiled, as Dynamic C would not, but must not be called. */
+struct ll_prefix_t;
+static inline void _pkt_buf2xmem(struct ll_prefix_t * LL, void * dest,
+	word len, word offset)
+{
+	exception(-1);
+}
+#endif
+
+
+#endif
@@ -0,0 +1,115 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	fat_sim.c
+
+	Stand-ins for what the FAT libraries use from the BIOS, and C
+	versions of the assembly functions of FAT16.LIB, for the host
+	simulation build.  This is included after the library headers, and
+	before their bodies.  A program calls fat_sim_init() before using
+	the libraries.
+
+***************************************************************************/
+
+// Dynamic C's stack segment starts at this logical address, so FAT16.LIB
+// compares an address with it to tell whether a variable is on the stack.
+// On the host the low 16 bits of an address say nothing, so everything is
+// treated as being on the stack, which makes the library wait for the
+// device (as with FAT_BLOCK) rather than return -EBUSY.
+#define STACKORG		0
+
+// xgetint() reads a word, so that comparing it with a constant such as
+// 0xAA55 works as it does with 16-bit ints.
+#define paddrSS(p)		paddr(p)
+#define xgetint(addr)	(*(word *)_dcsim_ptr(addr))
+#define xavail(addr)		_xavail(addr)
+
+#define XMEM_AVAIL		(1L << 24)
+
+// Return the xmem available, and allocate all of it if addr is not NULL.
+long _xavail(long * addr)
+{
+	if (addr)
+		*addr = xalloc(XMEM_AVAIL);
+	return XMEM_AVAIL;
+}
+
+// Release xmem allocated by xalloc() or _xalloc().
+void xrelease(long addr, long size)
+{
+	free(_dcsim_ptr(addr));
+}
+
+/* The time, in the host's struct tm (which is the ANSI one) */
+#define tm_mon2month(x)		((x) + 1)
+#define month2tm_mon(x)		((x) - 1)
+
+int tm_rd(struct tm * t)
+{
+	auto time_t now;
+
+	now = time(NULL);
+	localtime_r(&now, t);
+	return 0;
+}
+
+// Do what the libraries' #GLOBAL_INITs do (other than setting things to
+// zero, as the host does).
+void fat_sim_init(void)
+{
+	fat_sysftc = -1;
+	fat_removableDev = fat_solderedDev = -2;
+	_fat_config_init();
+}
+
+/* The FAT sector searches, which take the xmem address of the first 16-bit
+   entry, and the number of bytes to search (rounded down to an even
+   number). */
+
+// Return the offset in bytes of the first free (zero) entry, or of the
+// entry just past the search window if none is free.
+word _fat_xfind_free(long src, word len)
+{
+	auto word * p;
+	auto unsigned i;
+
+	p = _dcsim_ptr(src);
+	for (i = 0; i < len / 2 && p[i]; ++i);
+	return i * 2;
+}
+
+// Return the length in bytes of the run of free entries at the start.
+word _fat_xnull_len(long src, word len)
+{
+	auto word * p;
+	auto unsigned i;
+
+	p = _dcsim_ptr(src);
+	for (i = 0; i < len / 2 && !p[i]; ++i);
+	return i * 2;
+}
+
+// Return the number of free entries.
+word _fat_xcount_free(long src, word len)
+{
+	auto word * p;
+	auto unsigned i, n;
+
+	p = _dcsim_ptr(src);
+	for (i = n = 0; i < len / 2; ++i)
+		n += !p[i];
+	return n;
+}
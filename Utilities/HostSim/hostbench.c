@@ -0,0 +1,483 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostbench.c
+
+	Benchmark and self test for the host simulation build (see
+	README.txt).  Runs on a workstation, using the unmodified C code of
+	CBUF.LIB, TBUF.LIB and TCHAIN.LIB.
+
+	  cbuf spec - checks each CBUF.LIB function against its function
+	              description, for several buffer sizes, with the data
+	              starting at every position in the buffer: empty and
+	              full buffers, short puts and gets, the span lengths
+	              when the data or space wraps, the locks, and
+	              buffer_init's checks of its size.  Then runs random
+	              operations against a simple model of the queue.
+	  cbuf      - passes a counting pattern through a circular buffer in
+	              chunks of every size, with buffer_put/buffer_get and
+	              with the span functions, checking every byte.  Then
+	              measures put/get throughput for a few chunk sizes.
+
+	The functions of CBUF.LIB written in assembly are replaced by the C
+	versions in cbuf_sim.c, so these tests check those C versions and
+	the library's own C functions (buffer_init and the span functions).
+	They do not test the assembly.  Samples/CBUF_SPANS.C runs the
+	pattern test on a Rabbit, against the assembly.
+	  loopback  - passes data through a pair of socket buffers, the way a
+	              TCP connection over the loopback interface uses them
+	              (it does not run the stack; see hostnet.c for that):
+	              the application appends to the sender's transmit
+	              buffer, segments of up to MSS bytes are read from it
+	              into a packet buffer, appended to the receiver's buffer
+	              from an ll_Gather (as tcp.lib does when a segment
+	              arrives), and deleted from the transmit buffer as if
+	              acked.  The receiving application extracts and checks
+	              the data.  This is run with _tbuf and with
+	              _tchain socket buffers.
+
+	When built as hostprobe (with PROBE_ENABLE defined), each segment of
+	the loopback test is timed by a probe, and the bytes received are
+	counted by another.  The probe report is printed at the end, and if a
+	file name is given, the probe trace is written to it (see
+	Utilities/ProbeTrace).
+
+	Exits with status 0 if all checks passed.
+
+***************************************************************************/
+#include "dcsim.h"
+
+// The libraries: all of the headers first, then the function bodies, as
+// Dynamic C compiles them.
+#include "gen/pool.h"
+#include "gen/cbuf.h"
+#include "gen/tbuf.h"
+#include "gen/tchain.h"
+#include "gen/probe.h"
+
+#include "pool_sim.c"
+#include "gen/pool.c"
+#include "gen/cbuf.c"
+#include "cbuf_sim.c"
+#include "gen/tbuf.c"
+#include "gen/tchain.c"
+#include "gen/probe.c"
+#include "probe_sim.c"
+
+#define CBUF_SIZE		1023			// Circular buffer capacity (2^n - 1)
+#define CBUF_CHUNK	300			// Largest chunk in cbuf pattern test
+#define SOCKBUF		4096			// Size of each socket buffer
+#define MSS				1460			// Largest segment
+#define LOOP_BYTES	(64L << 20)	// Bytes transferred by each loopback test
+#define BENCH_MS		1000			// Duration of each throughput test
+#define PATLEN			251			// Period of test pattern (a prime)
+
+byte pattern[PATLEN + 65536];
+byte chunk[65536];
+unsigned long errors;
+
+// Check len bytes of data, which should be the pattern from offset pos.
+void check(const byte * data, word len, unsigned long pos)
+{
+	if (memcmp(data, pattern + pos % PATLEN, len))
+		++errors;
+}
+
+/*** cbuf spec ***/
+
+// Count a failed check, and say where it was.
+#define SPEC(cond) \
+	do { if (!(cond)) { ++errors; printf("  %s:%d: size %d pos %d: %s\n", \
+	     __FILE__, __LINE__, size, pos, #cond); } } while (0)
+
+// Check that the spans are consistent with the function descriptions:
+// they add up to total, span[1] is empty unless span[0] reaches the end of
+// the data area, and both lie within the data area.
+#define SPEC_SPANS(cb, span, total) \
+	do { \
+		SPEC((span)[0].len + (span)[1].len == (total)); \
+		SPEC(!(span)[1].len || (span)[0].data + (span)[0].len == \
+		                       (cb)->buffer + (cb)->mask + 1); \
+		SPEC(!(span)[1].len || (span)[1].data == (cb)->buffer); \
+		SPEC(!(span)[0].len || (span)[0].data >= (cb)->buffer && \
+		     (span)[0].data + (span)[0].len <= (cb)->buffer + (cb)->mask + 1); \
+	} while (0)
+
+byte spec_space[1023 + CBUF_OVERHEAD];
+byte model[1023];				// Bytes expected in the buffer, oldest first
+int mlen;
+byte seq;						// Next byte to write
+
+// Write n bytes of the sequence to the buffer with spans, and to the model.
+int spec_commit(cbuf_t * cb, int n)
+{
+	auto cbuf_span_t span[2];
+	auto int i;
+
+	n = u_min(n, buffer_space_spans(cb, span));
+	for (i = 0; i < n; ++i, ++seq) {
+		if (i < span[0].len)
+			span[0].data[i] = seq;
+		else
+			span[1].data[i - span[0].len] = seq;
+		model[mlen++] = seq;
+	}
+	buffer_commit(cb, n);
+	return n;
+}
+
+// Remove n bytes from the model.
+void spec_consume(int n)
+{
+	memmove(model, model + n, mlen - n);
+	mlen -= n;
+}
+
+void cbuf_spec_test(void)
+{
+	static const int sizes[] = { 3, 7, 15, 1023 };
+	auto cbuf_t * cb;
+	auto cbuf_span_t span[2];
+	auto byte buf[1100];
+	auto int size, pos, i, i2, n, s;
+	auto unsigned long e;
+
+	e = errors;
+	cb = (cbuf_t *)spec_space;
+	size = pos = 0;
+	SPEC(buffer_init(NULL, 7) == -EINVAL);
+	SPEC(buffer_init(cb, 1) == -EINVAL);
+	for (size = 4; size <= 8; ++size)
+		if (size != 7)
+			SPEC(buffer_init(cb, size) == -EINVAL);
+	SPEC(buffer_init(cb, 1024) == -EINVAL);
+	size = 7;
+	SPEC(buffer_init(cb, size) == 0);
+	SPEC(buffer_wrlock(NULL) == 0 && buffer_rdlock(NULL) == 0);
+	SPEC(buffer_wrlock(cb) == 1 && buffer_wrlock(cb) == 0);
+	SPEC(buffer_rdlock(cb) == 1 && buffer_rdlock(cb) == 0);
+	buffer_wrunlock(cb);
+	SPEC(buffer_wrlock(cb) == 1 && buffer_rdlock(cb) == 0);
+	buffer_rdunlock(cb);
+	SPEC(buffer_rdlock(cb) == 1);
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		size = sizes[s];
+		// Start with the head at every position in the data area.
+		for (pos = 0; pos <= size; ++pos) {
+			SPEC(buffer_init(cb, size) == 0);
+			for (i = 0; i < pos; ++i)
+				SPEC(buffer_putch(cb, 0) == 1 && buffer_getch(cb) == 0);
+			mlen = 0;
+
+			// Empty
+			SPEC(buffer_length(cb) == size);
+			SPEC(buffer_used(cb) == 0 && buffer_free(cb) == size);
+			SPEC(buffer_getch(cb) == -1 && buffer_peek(cb) == -1);
+			SPEC(buffer_get(cb, buf, size) == 0);
+			SPEC(buffer_peek_spans(cb, span) == 0);
+			SPEC(span[0].len == 0 && span[1].len == 0);
+			n = buffer_space_spans(cb, span);
+			SPEC(n == size);
+			SPEC(span[0].data == cb->buffer + pos % (size + 1));
+			SPEC_SPANS(cb, span, n);
+
+			// Fill through the spans: full
+			SPEC(spec_commit(cb, size + 1) == size);
+			SPEC(buffer_used(cb) == size && buffer_free(cb) == 0);
+			SPEC(buffer_putch(cb, 0) == 0);
+			SPEC(buffer_put(cb, buf, 1) == 0);
+			SPEC(buffer_space_spans(cb, span) == 0);
+			SPEC(span[0].len == 0 && span[1].len == 0);
+			n = buffer_peek_spans(cb, span);
+			SPEC(n == size);
+			SPEC(span[0].data == cb->buffer + pos % (size + 1));
+			SPEC_SPANS(cb, span, n);
+			SPEC(!memcmp(span[0].data, model, span[0].len));
+			SPEC(!memcmp(span[1].data, model + span[0].len, span[1].len));
+
+			// Single bytes, then a get of more than is held
+			SPEC(buffer_peek(cb) == model[0]);
+			SPEC(buffer_getch(cb) == model[0]);
+			spec_consume(1);
+			SPEC(buffer_used(cb) == size - 1);
+			SPEC(buffer_get(cb, buf, size + 5) == size - 1);
+			SPEC(!memcmp(buf, model, size - 1));
+			spec_consume(size - 1);
+			SPEC(buffer_used(cb) == 0);
+
+			// A put of more than fits, from the new position
+			for (i = 0; i < size + 5; ++i)
+				buf[i] = seq + i;
+			SPEC(buffer_put(cb, buf, size + 5) == size);
+			for (i = 0; i < size; ++i)
+				SPEC(buffer_getch(cb) == buf[i]);
+			SPEC(buffer_getch(cb) == -1);
+
+			// Partial commit and consume
+			n = spec_commit(cb, size / 2 + 1);
+			SPEC(buffer_used(cb) == n);
+			SPEC(buffer_peek_spans(cb, span) == n);
+			buffer_consume(cb, 1);
+			spec_consume(1);
+			SPEC(buffer_get(cb, buf, n) == n - 1);
+			SPEC(!memcmp(buf, model, n - 1));
+			spec_consume(n - 1);
+
+			// Flush
+			SPEC(buffer_putch(cb, 1) == 1);
+			buffer_flush(cb);
+			SPEC(buffer_used(cb) == 0 && buffer_getch(cb) == -1);
+		}
+
+		// Random operations against the model
+		SPEC(buffer_init(cb, size) == 0);
+		mlen = 0;
+		srand(size);
+		for (i = 0; i < 20000; ++i) {
+			n = rand() % (size + 2);
+			switch (rand() % 6) {
+			case 0:
+				spec_commit(cb, n);
+				break;
+			case 1:
+				n = u_min(n, buffer_peek_spans(cb, span));
+				SPEC_SPANS(cb, span, mlen);
+				SPEC(!memcmp(span[0].data, model, u_min(n, span[0].len)));
+				buffer_consume(cb, n);
+				spec_consume(n);
+				break;
+			case 2:
+				memcpy(buf, pattern + seq, n);
+				i2 = buffer_put(cb, buf, n);
+				SPEC(i2 == u_min(n, size - mlen));
+				n = i2;
+				memcpy(model + mlen, buf, n);
+				mlen += n;
+				seq += n;
+				break;
+			case 3:
+				SPEC(buffer_get(cb, buf, n) == u_min(n, mlen));
+				n = u_min(n, mlen);
+				SPEC(!memcmp(buf, model, n));
+				spec_consume(n);
+				break;
+			case 4:
+				if (buffer_putch(cb, seq))
+					model[mlen++] = seq++;
+				else
+					SPEC(mlen == size);
+				break;
+			case 5:
+				SPEC(buffer_getch(cb) == (mlen ? model[0] : -1));
+				if (mlen)
+					spec_consume(1);
+				break;
+			}
+			SPEC(buffer_used(cb) == mlen && buffer_free(cb) == size - mlen);
+		}
+	}
+	printf("cbuf spec: %lu errors\n", errors - e);
+}
+
+/*** cbuf ***/
+
+byte cbuf_space[CBUF_SIZE + CBUF_OVERHEAD];
+cbuf_t * cbuf;
+unsigned long cb_wr, cb_rd;		// Bytes written to and read from cbuf
+
+void cbuf_write(int n, int spans)
+{
+	auto cbuf_span_t span[2];
+
+	if (spans) {
+		n = u_min(n, buffer_space_spans(cbuf, span));
+		memcpy(span[0].data, pattern + cb_wr % PATLEN, u_min(n, span[0].len));
+		if (n > span[0].len)
+			memcpy(span[1].data, pattern + (cb_wr + span[0].len) % PATLEN,
+			       n - span[0].len);
+		buffer_commit(cbuf, n);
+	}
+	else
+		n = buffer_put(cbuf, pattern + cb_wr % PATLEN, n);
+	cb_wr += n;
+}
+
+void cbuf_read(int n, int spans)
+{
+	auto cbuf_span_t span[2];
+
+	if (spans) {
+		n = u_min(n, buffer_peek_spans(cbuf, span));
+		check(span[0].data, u_min(n, span[0].len), cb_rd);
+		if (n > span[0].len)
+			check(span[1].data, n - span[0].len, cb_rd + span[0].len);
+		buffer_consume(cbuf, n);
+	}
+	else {
+		n = buffer_get(cbuf, chunk, n);
+		check(chunk, n, cb_rd);
+	}
+	cb_rd += n;
+}
+
+void cbuf_test(void)
+{
+	auto int n, mode;
+	auto unsigned long t, bytes;
+
+	cbuf = (cbuf_t *)cbuf_space;
+	buffer_init(cbuf, CBUF_SIZE);
+	cb_wr = cb_rd = 0;
+
+	// Mode bit 0 selects spans for writing, bit 1 selects spans for reading
+	for (mode = 0; mode < 4; ++mode) {
+		for (n = 1; n <= CBUF_CHUNK; ++n) {
+			cbuf_write(n, mode & 1);
+			cbuf_write(CBUF_CHUNK + 1 - n, mode & 1);
+			cbuf_read(n, mode & 2);
+			cbuf_read(CBUF_CHUNK, mode & 2);
+		}
+		cbuf_read(CBUF_SIZE, mode & 2);
+		if (buffer_used(cbuf) || cb_rd != cb_wr)
+			++errors;
+	}
+	printf("cbuf: %lu bytes checked, %lu errors\n", cb_rd, errors);
+
+	for (n = 16; n <= 1024; n *= 4) {
+		if (n > CBUF_SIZE)
+			n = CBUF_SIZE;
+		for (bytes = 0, t = MS_TIMER; MS_TIMER - t < BENCH_MS; ) {
+			bytes += buffer_put(cbuf, chunk, n);
+			buffer_get(cbuf, chunk, n);
+		}
+		printf("  %4d-byte put/get %10.1f MB/s\n", n,
+		       bytes / 1048.576 / BENCH_MS);
+	}
+}
+
+/*** loopback ***/
+
+#ifdef PROBE_ENABLE
+Probe _tbuf_seg_probe, _tbuf_recv_probe, _tchain_seg_probe, _tchain_recv_probe;
+#endif
+
+// One loopback transfer through a pair of socket buffers of type T (_tbuf
+// or _tchain), using that type's functions.  Prints the throughput.
+#define LOOPBACK(T, wr, rd) do { \
+	auto ll_Gather g; \
+	auto byte pkt[MSS]; \
+	auto unsigned long sent, acked, recvd, t; \
+	auto word n; \
+	memset(&g, 0, sizeof(g)); \
+	g.flags = LLG_STAT_DATA2 | LLG_STAT_DATA3; \
+	g.data2 = (char *)pkt; \
+	sent = acked = recvd = 0; \
+	t = MS_TIMER; \
+	while (recvd < LOOP_BYTES) { \
+		/* Sending application */ \
+		n = u_min(T##_remain(wr), LOOP_BYTES - sent); \
+		sent += T##_append(wr, pattern + sent % PATLEN, n); \
+		/* Transmit a segment, and deliver it to the receiver */ \
+		PROBE_ENTER(T##_seg_probe, #T " segment"); \
+		n = u_min(MSS, (wr)->len); \
+		T##_xread(pkt, wr, 0, n); \
+		g.len2 = n; \
+		n = T##_gappend(rd, &g, 0, u_min(n, T##_remain(rd))); \
+		acked += T##_delete(wr, n); \
+		PROBE_EXIT(T##_seg_probe); \
+		/* Receiving application */ \
+		n = T##_extract(chunk, rd, (rd)->len); \
+		PROBE_COUNT(T##_recv_probe, #T " recv", n); \
+		check(chunk, n, recvd); \
+		recvd += n; \
+	} \
+	if (acked != LOOP_BYTES || (wr)->len || (rd)->len) \
+		++errors; \
+	t = MS_TIMER - t; \
+	printf("  %-8s %10.1f MB/s\n", #T, \
+	       LOOP_BYTES / 1048.576 / (t ? t : 1)); \
+} while (0)
+
+void loopback_test(void)
+{
+	auto _tbuf twr, trd;
+	auto _tchain cwr, crd;
+
+	printf("loopback: %ld bytes, MSS %d, %d byte socket buffers\n",
+	       LOOP_BYTES, MSS, SOCKBUF);
+
+	memset(&twr, 0, sizeof(twr));
+	memset(&trd, 0, sizeof(trd));
+	twr.buf = malloc(SOCKBUF);
+	trd.buf = malloc(SOCKBUF);
+	twr.maxlen = trd.maxlen = SOCKBUF;
+	LOOPBACK(_tbuf, &twr, &trd);
+	free(twr.buf);
+	free(trd.buf);
+
+	memset(&cwr, 0, sizeof(cwr));
+	memset(&crd, 0, sizeof(crd));
+	cwr.maxlen = crd.maxlen = SOCKBUF;
+	_tchain_pool_init(2 * (SOCKBUF / TCHAIN_CHUNK + 1));
+	LOOPBACK(_tchain, &cwr, &crd);
+	if (pavail(&_tchain_pool) != _tchain_pool.nel)
+		++errors;
+}
+
+#ifdef PROBE_ENABLE
+// Print the probe report, and write the trace to the named file.
+void probe_output(const char * name)
+{
+	auto ProbeCursor c;
+	auto char buf[PROBE_LINE];
+	auto FILE * f;
+
+	printf("probes:\n");
+	probe_print();
+	if (!name)
+		return;
+	if (!(f = fopen(name, "w"))) {
+		perror(name);
+		++errors;
+		return;
+	}
+	probe_trace_start(&c);
+	while (!probe_trace_line(&c, buf))
+		fprintf(f, "%s\n", buf);
+	fclose(f);
+	printf("trace written to %s\n", name);
+}
+#endif
+
+int main(int argc, char ** argv)
+{
+	auto long i;
+
+	for (i = 0; i < sizeof(pattern); ++i)
+		pattern[i] = i % PATLEN;
+	errors = 0;
+
+	cbuf_spec_test();
+	cbuf_test();
+	loopback_test();
+#ifdef PROBE_ENABLE
+	probe_output(argc > 1 ? argv[1] : NULL);
+#endif
+
+	printf("%lu errors\n%s\n", errors, errors ? "FAILED" : "PASSED");
+	return errors != 0;
+}
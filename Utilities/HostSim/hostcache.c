@@ -0,0 +1,374 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostcache.c
+
+	Workload replay for the sector cache of FATFTC.LIB, for the host
+	simulation build (see README.txt).  The FAT libraries are built as in
+	hostfat.c, but the RAM disk is a file (the device image), mapped into
+	memory, so a filesystem can be kept from one run to the next, or
+	copied from a card.  A new image is created (empty, so it is
+	formatted when mounted) if the file doesn't exist.
+
+	The workload is read from a trace file, one operation per line:
+
+		mkdir PATH           create a directory, if it doesn't exist
+		write PATH BYTES     (re)create a file of BYTES bytes
+		append PATH BYTES    add BYTES bytes to the end of a file
+		read PATH [BYTES]    read a whole file (which must be BYTES long)
+		open PATH            look up a file or directory (fat_Status)
+		list PATH            read all the entries of a directory
+		delete PATH          delete a file
+		sync                 flush the cache (fat_SyncPartition)
+		phase NAME           count what follows under NAME
+		repeat N ... end     do the lines in between N times
+		# ...                comment
+
+	Paths use forward slashes.  At the end, the operations, cache hits
+	and misses (fatftc_read() calls), device sector reads and writes, and
+	the time of each phase are printed.  Build with FAT_PROTBUFS=0 (as
+	hostcachelru is) to compare with plain LRU replacement.
+
+	Usage: hostcache [-s sectors] image trace
+
+	-s gives the size of a new image (default 8192 sectors, 4 MB).
+
+	Exits with status 0 if every operation succeeded.
+
+***************************************************************************/
+#define FAT_BLOCK
+#define FAT_USE_FORWARDSLASH
+#define FATFTC_STATS
+
+// The image has no erase blocks (see RAMDISK_FAT.LIB).
+#define RAMDISK_ERASE_SECTORS	0
+
+// Add the RAM disk as a custom FAT device, formatting it when first mounted
+#define _DRIVER_CUSTOM "ramdisk_fat.h"
+#define _DRIVER_CUSTOM_INIT { "RD", ram_InitDriver, _DRIVER_CALLBACK, },
+#define _DEVICE_CUSTOM_0 { ram_InitDriver, _DEVICE_CALLBACK, 0, 0, \
+				FDDF_MOUNT_PART_0 | FDDF_MOUNT_DEV_0 | \
+				FDDF_COND_DEV_FORMAT | FDDF_COND_PART_FORMAT, "RAMDISK", },
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DCSIM_LONG32
+#include "dcsim.h"
+#include "gen/errno.h"
+#include "gen/probe.h"
+
+// Dynamic C doesn't pad structures.
+#pragma pack(1)
+
+#include "gen/fat16.h"
+
+#include "fat_sim.c"
+#include "gen/probe.c"
+#include "gen/part_defs.c"
+#include "gen/part.c"
+#include "gen/fatftc.c"
+#include "gen/fat_config.c"
+#include "gen/fat16.c"
+#include "gen/ramdisk_fat.c"
+
+#define IMAGE_SECTORS	8192			// Default size of a new image
+#define MAX_PHASES		16
+#define MAX_REPEAT		8				// Nesting depth of repeat
+
+typedef struct {
+	char		name[16];
+	uint32	ops;
+	uint32	hits;
+	uint32	misses;
+	uint32	reads;
+	uint32	writes;
+	uint32	ms;
+} Phase;
+
+Phase phases[MAX_PHASES];
+int nphases;
+Phase * phase;							// Phase being counted
+uint32 phase_hits, phase_misses, phase_start;
+
+fat_part * part;
+FATfile file;
+char buf[1024];
+
+char ** args;
+int nargs;
+
+// Add what has been done since the last call to the current phase.
+void count_phase(void)
+{
+	auto ram_stats st;
+
+	if (!phase || ram_GetStats(part->dev->dev_num, &st, 1))
+		return;
+	phase->hits += _ftc.hits - phase_hits;
+	phase->misses += _ftc.misses - phase_misses;
+	phase->reads += st.reads;
+	phase->writes += st.writes;
+	phase->ms += MS_TIMER - phase_start;
+	phase_hits = _ftc.hits;
+	phase_misses = _ftc.misses;
+	phase_start = MS_TIMER;
+}
+
+// Count what follows under the phase called name.
+void start_phase(const char * name)
+{
+	auto int i;
+
+	count_phase();
+	for (i = 0; i < nphases && strcmp(phases[i].name, name); ++i)
+		;
+	if (i == nphases) {
+		if (nphases == MAX_PHASES) {
+			fprintf(stderr, "more than %d phases\n", MAX_PHASES);
+			exit(1);
+		}
+		snprintf(phases[nphases++].name, sizeof(phases[0].name), "%s", name);
+	}
+	phase = phases + i;
+}
+
+// Write bytes of data to the end of the open file.
+int write_bytes(int32 bytes)
+{
+	auto int rc, n;
+
+	memset(buf, 'x', sizeof(buf));
+	for (rc = 0; bytes > 0 && rc >= 0; bytes -= n) {
+		n = bytes < sizeof(buf) ? (int)bytes : sizeof(buf);
+		rc = fat_Write(&file, buf, n);
+	}
+	return rc < 0 ? rc : 0;
+}
+
+int do_write(const char * path, int32 bytes, int append)
+{
+	auto int rc, rc2;
+	auto int32 prealloc;
+
+	if (!append && (rc = fat_Delete(part, FAT_FILE, path)) < 0 &&
+	    rc != -ENOENT)
+		return rc;
+	prealloc = 0;
+	if ((rc = fat_Open(part, path, FAT_FILE, FAT_CREATE, &file,
+	                   &prealloc)) < 0)
+		return rc;
+	if (!(rc = fat_Seek(&file, 0, SEEK_END)))
+		rc = write_bytes(bytes);
+	rc2 = fat_Close(&file);
+	return rc < 0 ? rc : rc2;
+}
+
+// Read the whole of a file, which must be expect bytes long if expect is
+// not negative.
+int do_read(const char * path, int32 expect)
+{
+	auto int rc;
+	auto int32 total;
+
+	if ((rc = fat_Open(part, path, FAT_FILE, 0, &file, NULL)) < 0)
+		return rc;
+	for (total = 0; (rc = fat_Read(&file, buf, sizeof(buf))) > 0; )
+		total += rc;
+	fat_Close(&file);
+	if (rc < 0 && rc != -EEOF)
+		return rc;
+	return expect >= 0 && total != expect ? -EIO : 0;
+}
+
+int do_list(const char * path)
+{
+	auto fat_dirent dent;
+	auto int rc;
+
+	if ((rc = fat_Open(part, path, FAT_DIR, 0, &file, NULL)) < 0)
+		return rc;
+	while (!(rc = fat_ReadDir(&file, &dent, FAT_INC_DEF)) && dent.name[0])
+		;
+	fat_Close(&file);
+	return rc == -EEOF ? 0 : rc;
+}
+
+// Replay the trace file.  Returns 0, or the error of the first operation
+// which failed.
+int replay(FILE * trace)
+{
+	auto struct { int pos, count, line; } rep[MAX_REPEAT];
+	auto char line[256], cmd[16], path[128];
+	auto fat_dirent dent;
+	auto int32 bytes;
+	auto int n, depth, lineno, rc;
+
+	for (depth = lineno = 0; fgets(line, sizeof(line), trace); ) {
+		++lineno;
+		n = sscanf(line, "%15s %127s %d", cmd, path, &bytes);
+		if (n < 1 || cmd[0] == '#')
+			continue;
+		if (!strcmp(cmd, "repeat") && n == 2 && depth < MAX_REPEAT) {
+			rep[depth].pos = (int)ftell(trace);
+			rep[depth].count = atoi(path);
+			rep[depth++].line = lineno;
+			continue;
+		}
+		if (!strcmp(cmd, "end") && depth) {
+			if (--rep[depth - 1].count > 0) {
+				fseek(trace, rep[depth - 1].pos, SEEK_SET);
+				lineno = rep[depth - 1].line;
+			}
+			else
+				--depth;
+			continue;
+		}
+		if (!strcmp(cmd, "phase") && n == 2) {
+			start_phase(path);
+			continue;
+		}
+
+		if (!strcmp(cmd, "sync"))
+			rc = fat_SyncPartition(part);
+		else if (n < 2)
+			rc = -EINVAL;
+		else if (!strcmp(cmd, "mkdir"))
+			rc = fat_CreateDir(part, path);
+		else if (!strcmp(cmd, "write") && n == 3)
+			rc = do_write(path, bytes, 0);
+		else if (!strcmp(cmd, "append") && n == 3)
+			rc = do_write(path, bytes, 1);
+		else if (!strcmp(cmd, "read"))
+			rc = do_read(path, n == 3 ? bytes : -1);
+		else if (!strcmp(cmd, "open"))
+			rc = fat_Status(part, path, &dent);
+		else if (!strcmp(cmd, "list"))
+			rc = do_list(path);
+		else if (!strcmp(cmd, "delete"))
+			rc = fat_Delete(part, FAT_FILE, path);
+		else
+			rc = -EINVAL;
+		if (rc < 0) {
+			printf("line %d: %s failed (%d)\n", lineno, cmd, rc);
+			return rc;
+		}
+		++phase->ops;
+	}
+	return 0;
+}
+
+// Mount the image, which is mapped into the RAM disk, and replay the
+// trace.
+int run(void)
+{
+	auto FILE * trace;
+	auto Phase * p;
+	auto int i, rc;
+
+	fat_sim_init();
+	if ((rc = fat_AutoMount(FDDF_USE_DEFAULT)) < 0 && rc != -EEXIST) {
+		printf("fat_AutoMount failed (%d)\n", rc);
+		return 1;
+	}
+	part = NULL;
+	for (i = 0; i < num_fat_devices * FAT_MAX_PARTITIONS; ++i)
+		if (fat_part_mounted[i] &&
+		    fat_part_mounted[i]->dev->driver->xxx_ReadSector ==
+		                                             ram_ReadSector) {
+			part = fat_part_mounted[i];
+			break;
+		}
+	if (!part) {
+		printf("No FAT partition on the image\n");
+		return 1;
+	}
+	printf("Image: %lu sectors, %d sectors per cluster\n",
+	       part->dev->seccount, part->sec_clust);
+	printf("Cache: %d entries, %d protected\n", FAT_MAXBUFS, FAT_PROTBUFS);
+
+	if (!(trace = fopen(args[1], "r"))) {
+		perror(args[1]);
+		return 1;
+	}
+	ram_GetStats(part->dev->dev_num, NULL, 1);
+	phase_hits = _ftc.hits;
+	phase_misses = _ftc.misses;
+	phase_start = MS_TIMER;
+	start_phase("-");
+	rc = replay(trace);
+	fclose(trace);
+	if (!rc)
+		rc = fat_SyncPartition(part);
+	count_phase();
+	fat_UnmountDevice(part->dev);
+
+	printf("%-10s %7s %8s %8s %6s %8s %8s %6s\n", "phase", "ops", "hits",
+	       "misses", "hit%", "dev rd", "dev wr", "ms");
+	for (p = phases; p < phases + nphases; ++p)
+		if (p->ops)
+			printf("%-10s %7lu %8lu %8lu %5lu%% %8lu %8lu %6lu\n", p->name,
+			       p->ops, p->hits, p->misses, p->hits + p->misses ?
+			       p->hits * 100 / (p->hits + p->misses) : 0,
+			       p->reads, p->writes, p->ms);
+	return rc < 0;
+}
+
+int main(int argc, char ** argv)
+{
+	auto struct stat st;
+	auto void * image;
+	auto unsigned long sectors;
+	auto int fd, opt, rc;
+
+	sectors = IMAGE_SECTORS;
+	while ((opt = getopt(argc, argv, "s:")) != -1)
+		if (opt == 's')
+			sectors = strtoul(optarg, NULL, 0);
+		else
+			argc = 0;
+	args = argv + optind;
+	nargs = argc - optind;
+	if (nargs != 2 || !sectors) {
+		fprintf(stderr, "Usage: hostcache [-s sectors] image trace\n");
+		return 2;
+	}
+
+	// The libraries take the xmem address of the image, so it must be
+	// mapped below 2 GB (see DCSIM_LONG32 in dcsim.h).
+	if ((fd = open(args[0], O_RDWR | O_CREAT, 0644)) < 0 ||
+	    fstat(fd, &st) ||
+	    (!st.st_size && ftruncate(fd, st.st_size = sectors * 512))) {
+		perror(args[0]);
+		return 1;
+	}
+	image = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+	             MAP_SHARED | MAP_32BIT, fd, 0);
+	if (image == MAP_FAILED) {
+		perror(args[0]);
+		return 1;
+	}
+	RAMDISK[0].data = image;
+	RAMDISK[0].sectors = st.st_size / 512;
+
+	rc = dcsim_run(run);
+	msync(image, st.st_size, MS_SYNC);
+	munmap(image, st.st_size);
+	close(fd);
+	return rc;
+}
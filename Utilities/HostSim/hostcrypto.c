@@ -0,0 +1,60 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostcrypto.c
+
+	Known-answer tests of the portable C crypto kernels, for the host
+	simulation build (see README.txt).  This builds
+	Samples/Crypto/CRYPTO_KERNELS.c with CRYPTO_PORTABLE_C set, using the
+	C code of MPARITH.LIB, AES_CORE.LIB, SHA1.LIB, SHA2.LIB and MD5.LIB.
+
+	The sample checks AES-128 (FIPS-197 and SP 800-38A CBC), SHA-1,
+	SHA-256, MD5 and modular exponentiation against published vectors,
+	then benchmarks them and prints a fingerprint of their output.  The
+	fingerprint must match that printed by the sample on a target, where
+	the assembly kernels are used (with CRYPTO_PORTABLE_C left at 0).
+	Each benchmark runs for BENCH_MS milliseconds (less than on a
+	target), and the host's cycles are those of the time-stamp counter
+	(see crypto_sim.c).
+
+	Exits with the number of tests which failed.
+
+***************************************************************************/
+
+// The crypto libraries assume that a long is 32 bits, and a char is
+// unsigned (see the Makefile).
+#define DCSIM_LONG32
+#define CRYPTO_PORTABLE_C	1
+#define BENCH_MS				200
+
+#include "dcsim.h"
+
+// The libraries: all of the headers first, then the function bodies, as
+// Dynamic C compiles them.
+#include "gen/mparith.h"
+#include "gen/aes_core.h"
+#include "gen/sha1.h"
+#include "gen/sha2.h"
+#include "gen/md5.h"
+
+#include "crypto_sim.c"
+#include "gen/mparith.c"
+#include "gen/aes_core.c"
+#include "gen/sha1.c"
+#include "gen/sha2.c"
+#include "gen/md5.c"
+
+#include "gen/crypto_kernels.c"
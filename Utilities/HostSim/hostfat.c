@@ -0,0 +1,87 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostfat.c
+
+	FAT filesystem benchmark on the RAM disk, for the host simulation
+	build (see README.txt).  This builds Samples/FileSystem/FAT/
+	FAT_BENCH.C, with FAT16.LIB, FATFTC.LIB, PART.LIB and RAMDISK_FAT.LIB
+	as they are on the target.  It runs the sample's workloads
+	(sequential write and read, random read, many small files, directory
+	listing) on a RAM disk, and prints the time and the device reads,
+	writes and erases of each, and checks the data read back.  The RAM
+	disk emulates a flash device, with the command and access times and
+	erase blocks below (see RAMDISK_FAT.LIB), and the sequential read
+	spends a millisecond passing on each sector.  hostfatnora is built
+	with FAT_READAHEAD set to 0, to compare the sequential read without
+	read-ahead.
+
+	The libraries keep xmem addresses in longs, and copy structures to
+	and from the disk, so they are built with the integer sizes of
+	Dynamic C (see DCSIM_LONG32 in dcsim.h, and INT16 in the Makefile),
+	and packed structures.
+
+	Exits with status 0 if all the workloads succeeded.
+
+***************************************************************************/
+#ifndef RAMDISK_CMD_MS
+#define RAMDISK_CMD_MS			1
+#endif
+#ifndef RAMDISK_READ_MS
+#define RAMDISK_READ_MS			1
+#endif
+#ifndef RAMDISK_WRITE_MS
+#define RAMDISK_WRITE_MS		1
+#endif
+#ifndef RAMDISK_ERASE_SECTORS
+#define RAMDISK_ERASE_SECTORS	8
+#endif
+#ifndef RAMDISK_ERASE_MS
+#define RAMDISK_ERASE_MS		4
+#endif
+#define BENCH_SEND_MS			1
+
+#define DCSIM_LONG32
+#include "dcsim.h"
+#include "gen/errno.h"
+#include "gen/probe.h"
+
+// Dynamic C doesn't pad structures.
+#pragma pack(1)
+
+#define main	fat_bench
+#include "gen/fat_bench.c"
+#undef main
+
+#include "fat_sim.c"
+#include "gen/probe.c"
+#include "gen/part_defs.c"
+#include "gen/part.c"
+#include "gen/fatftc.c"
+#include "gen/fat_config.c"
+#include "gen/fat16.c"
+#include "gen/ramdisk_fat.c"
+
+static int run(void)
+{
+	fat_sim_init();
+	return fat_bench();
+}
+
+int main(void)
+{
+	return dcsim_run(run);
+}
@@ -0,0 +1,315 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostftl.c
+
+	Sector write latency of the flash translation layer (FATFTL.LIB) on a
+	simulated NAND flash (nand_sim.c), for the host simulation build (see
+	README.txt).  The FAT libraries are built as in hostfat.c, with the
+	FTL over the simulated device as a custom driver, as fat_config.lib
+	sets it up for a board with NAND flash.
+
+	The FTL is called as the sector cache of FATFTC.LIB calls it.  A write
+	which the FTL refuses (-EDRVBUSY) is tried again after a call to
+	ftl_InformStatus(FTLS_BACKGROUND), as fat_tick() makes, and one it
+	starts (-EBUSY) is driven to completion.  Between writes the
+	application calls fat_tick() every TICK_US.
+
+	The device is first filled to 3/4 of its logical sectors, then
+	sectors are overwritten, one every GAP_US: a quarter of them at random
+	in a small hot region (as the FAT and directories are), and the rest
+	in turn through the data after it (as files are rewritten), so
+	garbage builds up and blocks must be collected.  The latency of each
+	write is from when the application asks for it to when it is done,
+	in simulated time (see nand_sim.c), so it includes waiting for
+	background work.  Writes come too often for the device to be idle
+	for 1/2 second, but not so often that it is always busy.  The
+	percentiles of the latencies are printed, with the compactions and
+	erases, and then every sector is read back and checked.
+
+	hostftlidle is built with FTL_GC_RESERVE and FTL_GC_BUDGET set to 0,
+	so that garbage is only collected once the device has been idle, or
+	when a write finds no erased block.  Compare the tails of the two.
+
+	Usage: hostftl [writes]
+
+	writes is the number of writes after the fill (default 20000).
+
+	Exits with status 0 if every write succeeded and all of the data
+	read back as written.
+
+***************************************************************************/
+#define FAT_NAND_DEVICE_USED
+
+// Add the FTL on the simulated NAND flash as a custom FAT device
+#define _DRIVER_CUSTOM "fatftl.h"
+#define _DRIVER_CUSTOM_INIT { "NT", ftl_InitDriver, _DRIVER_CALLBACK, },
+#define _DEVICE_CUSTOM_0 { ftl_InitDriver, _DEVICE_CALLBACK, 0, 0, \
+				FDDF_MOUNT_PART_ALL | FDDF_MOUNT_DEV_0, "NFLASH-0", },
+#define _FTL_DRIVER "../nand_sim.h"
+#define _FTL_DRIVER_INIT { "NF", nf_InitDriver, _DRIVER_CALLBACK, }
+
+#define DCSIM_LONG32
+#include "dcsim.h"
+#include "gen/errno.h"
+#include "gen/probe.h"
+
+// The libraries run on the simulated time of the device.
+#undef MS_TIMER
+#define MS_TIMER		(nand_now / 1000)
+
+// Dynamic C doesn't pad structures.
+#pragma pack(1)
+
+// FATFTL.LIB sizes its block cache by that of FATFTC.LIB, which the BIOS
+// defines on the target.
+#include "gen/fatftc.h"
+#include "gen/fat16.h"
+
+#include "fat_sim.c"
+#include "nand_sim.c"
+#include "gen/probe.c"
+#include "gen/part_defs.c"
+#include "gen/part.c"
+#include "gen/fatftc.c"
+#include "gen/fat_config.c"
+#include "gen/fat16.c"
+#include "gen/fatftl.c"
+
+#define WRITES			20000		// Default number of writes after the fill
+#define GAP_US			20000		// Time from one write to the next
+#define TICK_US		1000		// Time between calls to fat_tick()
+#define HOT_SECTORS	64			// Size of the hot region
+#define MAX_TRIES		100000	// Give up on a write after this many calls
+
+mbr_drvr driver;
+mbr_dev device;
+
+unsigned long sectors;				// Logical sectors written
+word * versions;						// Times each sector has been written
+unsigned long * latency;			// Of each write after the fill, in us
+unsigned long next_tick;			// When fat_tick() is next due
+unsigned long max_tick;				// Longest fat_tick()
+char buf[512];
+
+// Fill buf with the contents of version v of sector lsn.
+void fill(unsigned long lsn, word v)
+{
+	auto int i;
+
+	for (i = 0; i < sizeof(buf); ++i)
+		buf[i] = (byte)(lsn * 7 + v * 13 + i);
+	*(word *)buf = (word)lsn;
+	*(word *)(buf + 2) = v;
+}
+
+// Call ftl_InformStatus() as fat_tick() does.
+int tick(void)
+{
+	auto unsigned long start;
+	auto int rc;
+
+	start = nand_now;
+	rc = ftl_InformStatus(&device, FTLS_BACKGROUND);
+	if (nand_now - start > max_tick)
+		max_tick = nand_now - start;
+	return rc;
+}
+
+// Let the application run until the time until, calling fat_tick() when
+// it is due.  A call may still be running at that time.  Calls missed
+// while one ran are not made up, as the application's loop would not.
+void run_until(unsigned long until)
+{
+	while ((long)(until - next_tick) > 0) {
+		if ((long)(nand_now - next_tick) < 0)
+			nand_now = next_tick;
+		else if ((long)(nand_now - until) >= 0)
+			break;
+		tick();
+		next_tick += TICK_US;
+		if ((long)(nand_now - next_tick) > 0)
+			next_tick = nand_now;
+	}
+	if ((long)(nand_now - until) < 0)
+		nand_now = until;
+}
+
+// Write the next version of sector lsn, as the cache does.
+int write_sector(unsigned long lsn)
+{
+	auto long tries;
+	auto int rc;
+
+	fill(lsn, ++versions[lsn]);
+	for (tries = 0; tries < MAX_TRIES; ++tries) {
+		rc = ftl_WriteSector(lsn, buf, NULL, &device, 0);
+		if (rc != -EDRVBUSY)
+			break;
+		tick();
+	}
+	while (rc == -EBUSY && ++tries < MAX_TRIES)
+		rc = ftl_InformStatus(&device, 0);
+	if (rc) {
+		printf("Write of sector %lu failed (%d)\n", lsn, rc);
+		return rc < 0 ? rc : -EIO;
+	}
+	return 0;
+}
+
+// Read back every sector, and check it is the last version written.
+int verify(void)
+{
+	auto char data[512];
+	auto unsigned long lsn;
+	auto int rc, bad;
+
+	for (lsn = bad = 0; lsn < sectors; ++lsn) {
+		do
+			rc = ftl_ReadSector(lsn, data, NULL, &device);
+		while (rc == -EBUSY || rc == -EDRVBUSY);
+		fill(lsn, versions[lsn]);
+		if (rc || memcmp(data, buf, sizeof(buf))) {
+			if (bad++ < 10)
+				printf("Sector %lu: %s version %u\n", lsn,
+				       rc ? "error reading" : "not", versions[lsn]);
+		}
+	}
+	if (bad)
+		printf("%d sectors bad\n", bad);
+	return bad;
+}
+
+int compare(const void * a, const void * b)
+{
+	auto unsigned long x, y;
+
+	x = *(const unsigned long *)a;
+	y = *(const unsigned long *)b;
+	return x < y ? -1 : x > y;
+}
+
+// Print the latency at per mille of the sorted latencies.
+void percentile(const char * name, int per_mille, long n)
+{
+	printf("  %-6s %8lu us\n", name, latency[(n - 1) * per_mille / 1000]);
+}
+
+// Print the latencies, and what the FTL and the device did.
+void report(long n)
+{
+	auto FTL_WearStats ws;
+	auto long i, over1, over5;
+
+	for (i = over1 = over5 = 0; i < n; ++i) {
+		over1 += latency[i] > 1000;
+		over5 += latency[i] > 5000;
+	}
+	qsort(latency, n, sizeof(latency[0]), compare);
+	printf("Write latency (%ld writes):\n", n);
+	percentile("p50", 500, n);
+	percentile("p90", 900, n);
+	percentile("p99", 990, n);
+	percentile("p99.9", 999, n);
+	percentile("max", 1000, n);
+	printf("  over 1 ms: %ld, over 5 ms: %ld\n", over1, over5);
+	printf("Longest fat_tick(): %lu us\n", max_tick);
+
+	ftl_WearStats(&device, &ws);
+	printf("Compactions: %u background, %u waited for\n", ws.bg_compact,
+	       ws.fg_compact);
+	printf("Erases: %lu (per block %u to %u), %u blocks free\n",
+	       ws.erase_total, ws.erase_min, ws.erase_max, ws.free);
+	printf("Device: %lu reads, %lu programs, %lu erases\n", nand_dev.reads,
+	       nand_dev.programs, nand_dev.erases);
+}
+
+long writes;
+
+int run(void)
+{
+	auto unsigned long lsn, seed, arrive, fill_sectors, next;
+	auto long i;
+	auto int rc;
+
+	fat_sim_init();
+	if (!(rc = ftl_InitDriver(&driver, NULL)))
+		while ((rc = ftl_EnumDevice(&driver, &device, 0)) == -EBUSY)
+			;
+	if (rc) {
+		printf("FTL initialization failed (%d)\n", rc);
+		return 1;
+	}
+	printf("NAND: %d blocks of %d sectors, FTL: %lu logical sectors\n",
+	       NAND_BLOCKS, NAND_PAGES, device.seccount);
+	printf("FTL_GC_RESERVE %d, FTL_GC_BUDGET %d ms\n", FTL_GC_RESERVE,
+	       FTL_GC_BUDGET);
+
+	fill_sectors = device.seccount / 4 * 3;
+	versions = calloc(fill_sectors, sizeof(versions[0]));
+	latency = malloc(writes * sizeof(latency[0]));
+	if (!versions || !latency) {
+		printf("Out of memory\n");
+		return 1;
+	}
+
+	// Fill, as the application writing its data in the first place
+	next_tick = nand_now;
+	for (sectors = 0; sectors < fill_sectors; ++sectors) {
+		if (write_sector(sectors))
+			return 1;
+		run_until(nand_now + GAP_US);
+	}
+
+	// The application asks for each write GAP_US after the last one was
+	// done, even if fat_tick() is still busy then.
+
+	seed = 1;
+	next = HOT_SECTORS;
+	for (i = 0; i < writes; ++i) {
+		seed = seed * 1103515245 + 12345;
+		if (seed & 0x30000) {
+			lsn = next;
+			if (++next == sectors)
+				next = HOT_SECTORS;
+		}
+		else
+			lsn = (seed >> 8) % HOT_SECTORS;
+		arrive = nand_now + GAP_US;
+		run_until(arrive);
+		if (write_sector(lsn))
+			return 1;
+		latency[i] = nand_now - arrive;
+	}
+	report(writes);
+
+	if (nand_dev.refused || nand_dev.bad_programs) {
+		printf("Device: %lu programs refused, %lu programmed over data\n",
+		       nand_dev.refused, nand_dev.bad_programs);
+		return 1;
+	}
+	return verify() != 0;
+}
+
+int main(int argc, char ** argv)
+{
+	writes = argc > 1 ? atol(argv[1]) : WRITES;
+	if (argc > 2 || writes <= 0) {
+		fprintf(stderr, "Usage: hostftl [writes]\n");
+		return 2;
+	}
+	return dcsim_run(run);
+}
@@ -0,0 +1,53 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostmalloc.c
+
+	Allocation trace replay benchmark of MALLOC.LIB, for the host
+	simulation build (see README.txt).  This builds
+	Samples/MALLOC_BENCH.C, which replays the same trace against plain
+	mspace_malloc() and the size-class slab front-end (mslab_malloc()),
+	and prints the throughput, peak extent and fragmentation of each.
+
+	The trace is 100 times as long as on a target, so that it takes long
+	enough to time.  The memory space is a third bigger, to allow for the
+	8-byte pointers and sizes of the host.
+
+***************************************************************************/
+#define BENCH_OPS			2000000L
+#define BENCH_HEAP_KB	128
+
+#include "dcsim.h"
+
+// MALLOC.LIB provides the system memory space itself.
+#undef _sys_malloc
+#undef _sys_free
+
+#include "gen/malloc.h"
+
+#include "malloc_sim.c"
+#include "gen/malloc.c"
+
+// The sample's main() returns void.
+#define main	malloc_bench
+#include "gen/malloc_bench.c"
+#undef main
+
+int main(void)
+{
+	malloc_bench();
+	return 0;
+}
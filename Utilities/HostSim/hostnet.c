@@ -0,0 +1,93 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostnet.c
+
+	TCP/IP throughput benchmark over the loopback interface, for the host
+	simulation build (see README.txt).  This builds Samples/tcpip/
+	LOOPBACK_BENCH.C, with DCRTCP.LIB and the libraries it uses (NET.LIB,
+	IP.LIB, TCP.LIB, UDP.LIB, ARP.LIB, PKTDRV.LIB, LOOPBACK.LIB, POOL.LIB,
+	TBUF.LIB and so on) as they are on the target, except for their
+	assembly (see net_sim.c and pool_sim.c).  It sends data over a TCP
+	connection, and UDP datagrams, from one socket to another through
+	127.0.0.1, and prints the time and throughput of each, and checks
+	the data received.
+
+	The libraries keep xmem addresses in longs, and map packet headers
+	onto structures, so they are built with the integer sizes of
+	Dynamic C (see DCSIM_LONG32 in dcsim.h, and INT16 in the Makefile),
+	and packed structures.  The simulated board is a Rabbit 4000 with no
+	network hardware but the loopback interface.
+
+	Exits with status 0 if both tests succeeded.
+
+***************************************************************************/
+#define DCSIM_LONG32
+#define DCSIM_NET
+#include "dcsim.h"
+#include "gen/errno.h"
+
+// The CPU macros which Dynamic C predefines (see SYSIODEFS.LIB)
+#define R4000				0x0200
+#define R5000				0x0300
+#define R6000				0x0400
+#define CPU_ID_MASK(x)	((x) & 0x1f00)
+#define _CPU_ID_			R4000
+#define RAM_SIZE			0x80
+#include "gen/probe.h"
+
+// Dynamic C doesn't pad structures.
+#pragma pack(1)
+
+#define main	loopback_bench
+#include "gen/loopback_bench.c"
+#undef main
+
+#include "net_sim.c"
+#include "pool_sim.c"
+#include "gen/pool.c"
+#include "gen/tbuf.c"
+#include "gen/probe.c"
+#include "probe_sim.c"
+#include "gen/tcp_config.c"
+#include "gen/dcrtcp.c"
+#include "gen/neterrno.c"
+#include "gen/net_defs.c"
+#include "gen/net.c"
+#include "gen/net_vars.c"
+#include "gen/servlist.c"
+#include "gen/arp.c"
+#include "gen/ip.c"
+#include "gen/udp.c"
+#include "gen/tcp.c"
+#include "gen/bsdname.c"
+#include "gen/icmp.c"
+#include "gen/dns.c"
+#include "gen/igmp.c"
+#include "gen/pktdrv.c"
+#include "gen/loopback.c"
+#include "gen/board_deps.c"
+
+static int run(void)
+{
+	net_sim_init();
+	return loopback_bench();
+}
+
+int main(void)
+{
+	return dcsim_run(run);
+}
@@ -0,0 +1,315 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostpool.c
+
+	Thread stress test of the lock-free pools of POOL.LIB (LFPool_t), and
+	test of its pool groups (PoolGroup_t), for the host simulation build
+	(see README.txt).  POOL.LIB is built as for hostbench, with its
+	assembly functions replaced by pool_sim.c.
+
+	The pool groups are checked first: that pgalloc() takes each size
+	from the smallest class which fits, that a request for an exhausted
+	class falls through to a larger class (with POOL_GROUP_SPILL) or to
+	malloc() (with POOL_GROUP_MALLOC), or fails, and that pgfree()
+	returns each element to the pool which it came from.
+
+	The main thread plays the part of the ISR: it is the only context
+	which calls lfpalloc().  It stamps each element with a sequence
+	number and hands it to one of CONSUMERS threads through a queue.
+	Each consumer checks the stamp and frees the element to its own
+	lane.  The main thread also frees every eighth element itself, to
+	lane 0, and any element it can't hand off because a queue is full.
+
+	Every element has a state flag, kept with atomic operations outside
+	the pool, which shows whether it has been allocated.  An element
+	which is allocated twice, freed when not allocated, or which is not
+	one of the pool's elements, is an error.  At the end, every element
+	must be free and allocatable once.
+
+	The pool functions themselves use plain loads and stores, as on the
+	Rabbit.  Their acquire and release points (_LFPOOL_ACQUIRE and
+	_LFPOOL_RELEASE in POOL.LIB), where a lane's index is read or
+	written, are fences here, so that neither gcc nor a weakly ordered
+	CPU moves the ring accesses past them.  They are compiled as separate
+	(not inlined) functions, as on the target, so that each call reads
+	the indexes from memory.
+
+	Usage: hostpool [allocations]
+
+	Exits with status 0 if all checks passed.
+
+***************************************************************************/
+#include "dcsim.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// POOL.LIB's functions are __nodebug, which here keeps them from being
+// inlined.
+#undef __nodebug
+#define __nodebug	__attribute__((noinline))
+#define _LFPOOL_ACQUIRE()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define _LFPOOL_RELEASE()	__atomic_thread_fence(__ATOMIC_RELEASE)
+
+#include "gen/pool.h"
+#include "pool_sim.c"
+#include "gen/pool.c"
+
+#define NEL				64				// Elements in the pool
+#define ELSIZE			16				// Size of each element
+#define CONSUMERS		3				// Freeing threads (lanes 1..CONSUMERS)
+#define LANES			(CONSUMERS + 1)
+#define QLEN			32				// Entries in each handoff queue (2^n)
+#define ALLOCS			20000000UL	// Default number of allocations
+
+byte elements[NEL * ELSIZE];
+char * ring_space[(NEL + 1) * LANES];
+LFPool_t pool;
+
+atomic_int allocated[NEL];			// Set while an element is allocated
+atomic_ulong errors;
+atomic_int done;
+
+// Handoff queue from the main thread to one consumer
+typedef struct {
+	void *			e[QLEN];
+	atomic_uint		head;				// Written by the main thread
+	atomic_uint		tail;				// Written by the consumer
+} Handoff;
+
+Handoff queue[CONSUMERS];
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("  " __VA_ARGS__); ++errors; } } while (0)
+
+// Return the class of group g whose pool holds e, or -1 if none does.
+int group_class(PoolGroup_t * g, void * e)
+{
+	auto Pool_t * p;
+	auto int c;
+
+	for (c = 0; c < g->classes; ++c) {
+		p = g->pool + c;
+		if ((long)e >= p->base.x &&
+		    (long)e < p->base.x + (long)p->nel * p->elsize)
+			return c;
+	}
+	return -1;
+}
+
+// Allocate size bytes from g, and check that the element came from class c
+// (-1 for malloc, -2 for no element).
+void * group_alloc(PoolGroup_t * g, word size, int c)
+{
+	auto void * e;
+	auto int got;
+
+	e = pgalloc(g, size);
+	got = e ? group_class(g, e) : -2;
+	CHECK(got == c, "pgalloc(%u) from class %d, not %d\n", size, got, c);
+	return e;
+}
+
+void test_groups(void)
+{
+	static const word nel[3] = { 2, 2, 1 };
+	auto PoolGroup_t g;
+	auto void * e[8];
+	auto int c, i;
+
+	// Classes of 16, 32 and 64 bytes
+	CHECK(!pool_group_create(&g, 16, 3, nel, POOL_GROUP_SPILL) &&
+	      g.classes == 3 && g.elsize[2] == 64, "pool_group_create failed\n");
+	e[0] = group_alloc(&g, 1, 0);
+	e[1] = group_alloc(&g, 16, 0);
+	e[2] = group_alloc(&g, 17, 1);
+	// Class 0 is exhausted, so this spills into class 1, then class 2.
+	e[3] = group_alloc(&g, 8, 1);
+	e[4] = group_alloc(&g, 8, 2);
+	e[5] = group_alloc(&g, 8, -2);
+	CHECK(g.spills[0] == 2 && g.spills[1] == 0 && g.fails == 1,
+	      "spills %lu %lu, fails %lu\n", g.spills[0], g.spills[1], g.fails);
+	// Too large for any class
+	e[5] = group_alloc(&g, 65, -2);
+	for (c = 0; c < 3; ++c)
+		CHECK(pgavail(&g, c) == 0 && pghwm(&g, c) == nel[c],
+		      "class %d: %u free, high water mark %u\n", c, pgavail(&g, c),
+		      pghwm(&g, c));
+	// Freeing the element which spilled into class 2 frees it there.
+	pgfree(&g, e[4]);
+	CHECK(pgavail(&g, 0) == 0 && pgavail(&g, 2) == 1,
+	      "pgfree of spilled element: %u and %u free\n", pgavail(&g, 0),
+	      pgavail(&g, 2));
+	pgfree(&g, e[0]);
+	e[0] = group_alloc(&g, 4, 0);
+	for (i = 0; i < 4; ++i)
+		pgfree(&g, e[i]);
+	for (c = 0; c < 3; ++c)
+		CHECK(pgavail(&g, c) == nel[c], "class %d: %u free at end, not %u\n",
+		      c, pgavail(&g, c), nel[c]);
+
+	// Without POOL_GROUP_SPILL, an exhausted class fails, and with
+	// POOL_GROUP_MALLOC, malloc() is used instead.
+	CHECK(!pool_group_create(&g, 16, 3, nel, 0), "pool_group_create failed\n");
+	e[0] = group_alloc(&g, 1, 0);
+	e[1] = group_alloc(&g, 1, 0);
+	e[2] = group_alloc(&g, 1, -2);
+	CHECK(g.spills[0] == 0 && g.fails == 1 && pgavail(&g, 1) == nel[1],
+	      "no spill: class 1 used, or fails %lu\n", g.fails);
+	CHECK(!pool_group_create(&g, 16, 3, nel, POOL_GROUP_MALLOC),
+	      "pool_group_create failed\n");
+	e[0] = group_alloc(&g, 1, 0);
+	e[1] = group_alloc(&g, 1, 0);
+	e[2] = group_alloc(&g, 1, -1);
+	e[3] = group_alloc(&g, 1000, -1);
+	CHECK(g.mallocs == 2 && g.fails == 0 && pgavail(&g, 1) == nel[1],
+	      "malloc: %lu mallocs, %lu fails\n", g.mallocs, g.fails);
+	for (i = 0; i < 4; ++i)
+		pgfree(&g, e[i]);
+	CHECK(pgavail(&g, 0) == nel[0], "malloc: class 0 not freed\n");
+	printf("pool groups: %s\n", errors ? "failed" : "ok");
+}
+
+// Return the index of element e, or -1 if it is not one of the pool's.
+int element_index(void * e)
+{
+	auto long off;
+
+	off = (byte *)e - elements;
+	if (off < 0 || off >= sizeof(elements) || off % ELSIZE) {
+		printf("  element %p is not in the pool\n", e);
+		++errors;
+		return -1;
+	}
+	return off / ELSIZE;
+}
+
+// Mark element e allocated (state 1) or free (0), checking that it was
+// in the other state.
+void mark(void * e, int state)
+{
+	auto int i;
+
+	if ((i = element_index(e)) < 0)
+		return;
+	if (atomic_exchange(&allocated[i], state) == state) {
+		printf("  element %d %s twice\n", i, state ? "allocated" : "freed");
+		++errors;
+	}
+}
+
+void * consumer(void * arg)
+{
+	auto Handoff * q;
+	auto unsigned long * stamp;
+	auto unsigned t;
+	auto int lane;
+
+	lane = (int)(intptr_t)arg;
+	q = queue + lane - 1;
+	for (;;) {
+		t = atomic_load(&q->tail);
+		if (t == atomic_load(&q->head)) {
+			if (atomic_load(&done) && t == atomic_load(&q->head))
+				break;
+			sched_yield();
+			continue;
+		}
+		stamp = q->e[t % QLEN];
+		atomic_store(&q->tail, t + 1);
+		if (stamp[1] != ~stamp[0]) {
+			printf("  element stamp %lx %lx corrupted\n", stamp[0], stamp[1]);
+			++errors;
+		}
+		mark(stamp, 0);
+		lfpfree(&pool, lane, stamp);
+	}
+	return NULL;
+}
+
+int main(int argc, char ** argv)
+{
+	auto pthread_t th[CONSUMERS];
+	auto Handoff * q;
+	auto unsigned long * e;
+	auto unsigned long n, allocs, empty, own;
+	auto unsigned h;
+	auto int i;
+	auto struct timespec t0, t1;
+	auto double secs;
+
+	allocs = argc > 1 ? strtoul(argv[1], NULL, 0) : ALLOCS;
+	test_groups();
+	lfpool_init(&pool, elements, NEL, ELSIZE, LANES, ring_space);
+	if (lfpavail(&pool) != NEL)
+		++errors;
+	for (i = 0; i < CONSUMERS; ++i)
+		pthread_create(th + i, NULL, consumer, (void *)(intptr_t)(i + 1));
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (n = empty = own = 0; n < allocs; ) {
+		if (!(e = lfpalloc(&pool))) {
+			++empty;				// All elements are with the consumers
+			sched_yield();
+			continue;
+		}
+		mark(e, 1);
+		e[0] = n;
+		e[1] = ~n;
+		q = queue + n % CONSUMERS;
+		h = atomic_load(&q->head);
+		if (++n % 8 == 0 || h - atomic_load(&q->tail) == QLEN) {
+			++own;
+			mark(e, 0);
+			lfpfree(&pool, 0, e);
+			continue;
+		}
+		q->e[h % QLEN] = e;
+		atomic_store(&q->head, h + 1);
+	}
+	atomic_store(&done, 1);
+	for (i = 0; i < CONSUMERS; ++i)
+		pthread_join(th[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = t1.tv_sec - t0.tv_sec + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	// Everything must be back in the pool, and allocatable exactly once.
+	if (lfpavail(&pool) != NEL) {
+		printf("  %u elements free at end, not %u\n", lfpavail(&pool), NEL);
+		++errors;
+	}
+	for (i = 0; i < NEL; ++i)
+		if (!(e = lfpalloc(&pool))) {
+			printf("  only %d elements allocatable at end\n", i);
+			++errors;
+			break;
+		}
+		else
+			mark(e, 1);
+	if (lfpalloc(&pool)) {
+		printf("  more than %u elements allocatable\n", NEL);
+		++errors;
+	}
+
+	printf("lfpool: %lu allocations, %lu freed to %d lanes, %lu by allocator\n",
+	       allocs, allocs - own, CONSUMERS, own);
+	printf("  %.1f M allocations/s, pool empty %lu times\n",
+	       allocs / secs / 1e6, empty);
+	printf("%lu errors\n%s\n", (unsigned long)errors,
+	       errors ? "FAILED" : "PASSED");
+	return errors != 0;
+}
@@ -0,0 +1,261 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	hostreg.c
+
+	Test of the log registries of REGISTRY.LIB (registry_log_update() and
+	registry_log_get()), for the host simulation build (see README.txt).
+	The library is built as it is, over the in-memory Zserver resources
+	of registry_sim.c.
+
+	The registry starts as a text registry, which the first access
+	imports.  Each update then sets two keys to the same new value, and
+	is repeated until the log has been compacted several times.  Every
+	update is also run with the power failing after each byte it writes
+	(including those of a compaction which follows it), and after each
+	failure the registry, re-indexed as after a reset, must hold either
+	the old or the new values of both keys, and accept another update.
+	Lastly the HEAD record of the log is damaged: the log must be
+	rebuilt from its other records, or if it has no commit, left as it
+	is and -EILSEQ returned, rather than replaced by the text registry.
+
+	Exits with status 0 if all checks passed.
+
+***************************************************************************/
+#include "dcsim.h"
+
+// Small, so that the log is compacted every few updates
+#define REGISTRY_LOG_COMPACT	512
+
+#include "registry_sim.c"
+#include "gen/registry.h"
+#include "gen/registry.c"
+
+#define UPDATES		64			// Updates of the crash test
+#define BASENAME		"reg"
+
+static ServerContext sctx;
+static unsigned long errors;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("  " __VA_ARGS__); ++errors; } } while (0)
+
+// Forget the index and close every resource, as a reset would.
+static void reset(void)
+{
+	rs_power_on();
+	while (_registry_logs[0])
+		_registry_log_drop(_registry_logs[0]);
+}
+
+// Read keys a and b of section sect.
+static int get(char * sect, char * a, char * b)
+{
+	auto RegistryEntry re[3];
+
+	memset(re, 0, sizeof(re));
+	a[0] = b[0] = 0;
+	re[0].key = "a";
+	re[0].value = a;
+	re[0].options = REGOPTION_STRING(16);
+	re[1].key = "b";
+	re[1].value = b;
+	re[1].options = REGOPTION_STRING(16);
+	re[2].options = REGOPTION_EOL;
+	return registry_log_get(BASENAME, sect, re, &sctx, NULL, 0, NULL);
+}
+
+// Set keys a and b of section sect to value.
+static int set(char * sect, char * value)
+{
+	auto RegistryEntry re[3];
+
+	memset(re, 0, sizeof(re));
+	re[0].key = "a";
+	re[0].value = value;
+	re[0].options = REGOPTION_STRING(16);
+	re[1].key = "b";
+	re[1].value = value;
+	re[1].options = REGOPTION_STRING(16);
+	re[2].options = REGOPTION_EOL;
+	return registry_log_update(BASENAME, sect, re, &sctx);
+}
+
+// registry_log_get() callback which counts sections and keys.
+static int count(int * n, int new_sect, char * sect, char * key, char * value)
+{
+	n[!new_sect]++;
+	return 0;
+}
+
+// Return the current log file (the one with a valid commit), or NULL.
+static RSFile * log_file(void)
+{
+	auto RSFile * f1, * f2;
+
+	f1 = rs_find(BASENAME ".l1");
+	f2 = rs_find(BASENAME ".l2");
+	if (f1 && f2)
+		return NULL;
+	return f1 ? f1 : f2;
+}
+
+static void test_import(void)
+{
+	auto char a[16], b[16];
+	auto int n[2];
+	auto int rc;
+
+	rs_put(BASENAME ".1", "name=host\n[net]\na=v0\nb=v0\n");
+	rc = get("net", a, b);
+	CHECK(!rc && !strcmp(a, "v0") && !strcmp(b, "v0"),
+	      "import: got %d \"%s\" \"%s\"\n", rc, a, b);
+	n[0] = n[1] = 0;
+	rc = registry_log_get(BASENAME, NULL, NULL, &sctx, count, 1, n);
+	CHECK(!rc && n[0] == 1 && n[1] == 3,
+	      "import: %d sections and %d keys enumerated\n", n[0], n[1]);
+	CHECK(rs_find(BASENAME ".l1") && rs_open_count() == 0,
+	      "import: no log file, or a resource left open\n");
+	printf("import: %s\n", errors ? "failed" : "ok");
+}
+
+static void test_commit(void)
+{
+	auto RSFile * f;
+	auto char a[16], b[16];
+	auto long len;
+	auto int rc;
+
+	f = log_file();
+	len = f->len;
+	rc = set("net", "v1");
+	// Two SET records of 8 + 3 + 1 + 2 bytes, and a COMMIT of 8
+	CHECK(!rc && f->len == len + 36 && f->data[f->len - 8] == _REGLOG_MAGIC &&
+	      f->data[f->len - 7] == _REGLOG_COMMIT,
+	      "commit: update returned %d, log grew by %ld\n", rc, f->len - len);
+	reset();
+	rc = get("net", a, b);
+	CHECK(!rc && !strcmp(a, "v1") && !strcmp(b, "v1"),
+	      "commit: got %d \"%s\" \"%s\" after reset\n", rc, a, b);
+	printf("append and commit: %s\n", errors ? "failed" : "ok");
+}
+
+// Run each update (setting the keys from "v<i+1>" to "v<i+2>") once to see
+// how many bytes it writes, then again with the power failing after each of
+// those bytes.
+static void test_crash(void)
+{
+	static RSFile before[RS_FILES], after[RS_FILES];
+	auto char a[16], b[16], old[16], new[16];
+	auto unsigned long trials, compactions, torn;
+	auto long start, len, limit;
+	auto int i, rc;
+
+	trials = compactions = torn = 0;
+	for (i = 0; i < UPDATES; ++i) {
+		sprintf(old, "v%d", i + 1);
+		sprintf(new, "v%d", i + 2);
+		memcpy(before, rs_files, sizeof(rs_files));
+		reset();
+		start = rs_written;
+		rc = set("net", new);
+		len = rs_written - start;
+		CHECK(!rc, "update %d returned %d\n", i, rc);
+		memcpy(after, rs_files, sizeof(rs_files));
+		for (limit = 0; limit < len; ++limit) {
+			memcpy(rs_files, before, sizeof(rs_files));
+			reset();
+			rs_write_limit = rs_written + limit;
+			rc = set("net", new);
+			if (rs_find(BASENAME ".l1") && rs_find(BASENAME ".l2"))
+				++compactions;
+			reset();
+			if (log_file() && log_file()->data[log_file()->len - 7] !=
+			    _REGLOG_COMMIT)
+				++torn;
+			rc = get("net", a, b);
+			CHECK(!rc && !strcmp(a, b) &&
+			      (!strcmp(a, old) || !strcmp(a, new)),
+			      "update %d, power fail at %ld: got %d \"%s\" \"%s\"\n",
+			      i, limit, rc, a, b);
+			rc = set("net", "x");
+			CHECK(!rc && !get("net", a, b) && !strcmp(a, "x"),
+			      "update %d, power fail at %ld: next update failed\n",
+			      i, limit);
+			CHECK(rs_open_count() == 0,
+			      "update %d, power fail at %ld: resource left open\n",
+			      i, limit);
+			++trials;
+		}
+		memcpy(rs_files, after, sizeof(rs_files));
+	}
+	reset();
+	rc = get("net", a, b);
+	sprintf(new, "v%d", UPDATES + 1);
+	CHECK(!rc && !strcmp(a, new), "crash: got \"%s\" after all updates\n", a);
+	CHECK(torn && compactions, "crash: %lu torn tails, %lu compactions\n",
+	      torn, compactions);
+	printf("power failures: %lu (%lu torn tails, %lu in compaction): %s\n",
+	       trials, torn, compactions, errors ? "failed" : "ok");
+}
+
+static void test_damaged(void)
+{
+	auto RSFile * f;
+	auto char a[16], b[16], last[16], name[SSPEC_MAXNAME + 4];
+	auto long len;
+	auto int rc;
+
+	sprintf(last, "v%d", UPDATES + 1);
+
+	// A damaged HEAD, with the rest intact: the log is rewritten.
+	reset();
+	f = log_file();
+	strcpy(name, f->name);
+	f->data[_REGLOG_HDR] ^= 0xFF;
+	rc = get("net", a, b);
+	f = log_file();
+	CHECK(!rc && !strcmp(a, last) && f && strcmp(f->name, name) &&
+	      f->data[1] == _REGLOG_HEAD,
+	      "damaged head: got %d \"%s\", log %s\n", rc, a, f ? f->name : "?");
+
+	// A damaged HEAD and no commit: the log is kept, and is not replaced by
+	// the text registry.
+	reset();
+	f = log_file();
+	f->len -= _REGLOG_HDR;
+	f->data[_REGLOG_HDR] ^= 0xFF;
+	strcpy(name, f->name);
+	len = f->len;
+	rc = get("net", a, b);
+	CHECK(rc == -EILSEQ, "damaged log: got %d, not %d\n", rc, -EILSEQ);
+	rc = set("net", "y");
+	CHECK(rc == -EILSEQ, "damaged log: update returned %d\n", rc);
+	f = log_file();
+	CHECK(f && !strcmp(f->name, name) && f->len == len &&
+	      rs_open_count() == 0, "damaged log: log replaced or left open\n");
+	printf("damaged head: %s\n", errors ? "failed" : "ok");
+}
+
+int main(void)
+{
+	test_import();
+	test_commit();
+	test_crash();
+	test_damaged();
+	printf("%lu errors\n%s\n", errors, errors ? "FAILED" : "PASSED");
+	return errors != 0;
+}
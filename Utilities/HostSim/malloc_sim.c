@@ -0,0 +1,59 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	malloc_sim.c
+
+	Stand-ins for what MALLOC.LIB uses from the BIOS, for the host
+	simulation build.  The system and application memory spaces are
+	taken from XMEM_AVAIL bytes of host memory when first used.  Root
+	memory is not simulated, so the _root_ functions must not be called.
+
+***************************************************************************/
+
+/* Run-time error codes (see the Dynamic C manual) */
+#define ERR_SYS_HEAP_NULL	249
+#define ERR_APP_HEAP_NULL	250
+#define ERR_HEAP_USAGE		251
+#define ERR_HEAP_CORRUPT	252
+
+#define XMEM_AVAIL		(1L << 20)
+
+// Return the xmem available, and allocate all of it if addr is not NULL.
+long _xavail(long * addr, word align, word type)
+{
+	auto long size;
+
+	size = XMEM_AVAIL;
+	if (addr)
+		*addr = _xalloc(&size, align, type);
+	return size;
+}
+
+word ravail(void)
+{
+	return 0;
+}
+
+void * ralloc(word len)
+{
+	exception(-ENOMEM);
+	return NULL;
+}
+
+int kbhit(void)
+{
+	return 0;
+}
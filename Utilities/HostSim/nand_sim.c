@@ -0,0 +1,217 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	nand_sim.c
+
+	The simulated NAND flash device of nand_sim.h, with the driver
+	functions of NFLASH_FAT.LIB which FATFTL.LIB calls.  This is included
+	after the library headers, and before their bodies.
+
+	Operations take simulated time, which nand_now counts.  Reading a page
+	waits while it is read and moved from the device.  Programming a page
+	moves it to the device and starts the program, and erasing a block
+	starts the erase.  The device is then busy until that would be done,
+	and each status poll while it is busy takes NAND_POLL_US.  So the
+	waits of the FTL are those it would have on a real device, but the
+	time taken by the code itself is not counted.
+
+	As on a NAND flash, a program can only clear bits.  One which would set
+	a bit is counted in bad_programs, as is a program refused because the
+	device was busy (in refused), since either loses data.  There are no
+	bad blocks, and the data is never corrupted, so ECCs are not kept.
+
+***************************************************************************/
+
+unsigned long nand_now;
+nf_device nand_dev;
+
+#define _nand_page(dev, sector)	((dev)->data + (sector) * NAND_PAGESIZE)
+
+// Poll the status of the device.  Returns -EBUSY if a program or erase is
+// still in progress.
+int _nand_poll(nf_device * dev)
+{
+	if (!dev->write_state)
+		return 0;
+	nand_now += NAND_POLL_US;
+	if ((long)(nand_now - dev->busy_until) < 0)
+		return -EBUSY;
+	dev->write_state = 0;
+	return 0;
+}
+
+// Erase a block, and start the device's wait for it.
+void _nand_erase(nf_device * dev, unsigned long block)
+{
+	memset(_nand_page(dev, block * NAND_PAGES), 0xFF,
+	       NAND_PAGES * NAND_PAGESIZE);
+	++dev->erases;
+	dev->write_state = -1;
+	dev->busy_until = nand_now + NAND_ERASE_US;
+}
+
+// Program len bytes at dest from src, clearing bits only.
+void _nand_program(nf_device * dev, byte * dest, const byte * src, int len)
+{
+	auto int i, bad;
+
+	for (i = bad = 0; i < len; ++i) {
+		bad |= src[i] & ~dest[i];
+		dest[i] &= src[i];
+	}
+	if (bad)
+		++dev->bad_programs;
+}
+
+int nf_InitDriver(mbr_drvr *driver, void *device_list)
+{
+	auto nf_device * dev;
+
+	dev = &nand_dev;
+	if (!dev->data) {
+		dev->data = malloc((long)NAND_BLOCKS * NAND_PAGES * NAND_PAGESIZE);
+		if (!dev->data)
+			return -ENOMEM;
+		memset(dev->data, 0xFF, (long)NAND_BLOCKS * NAND_PAGES * NAND_PAGESIZE);
+		dev->mbrtype = MBRTYPE_FLASH;
+	}
+
+	driver->xxx_EnumDevice = nf_EnumDevice;
+	driver->xxx_ReadSector = nf_ReadSector;
+	driver->xxx_WriteSector = nf_WriteSector;
+	driver->xxx_FormatCylinder = NULL;
+	driver->xxx_InformStatus = nf_InformStatus;
+	driver->xxx_ReadMulti = NULL;
+	driver->xxx_WriteMulti = NULL;
+	driver->type[0] = dev->mbrtype;
+	driver->ndev = 0;
+	driver->maxdev = _NFLASH_MAXDEVICES;
+	driver->dlist = NULL;
+	driver->next = NULL;
+	driver->dev_struct = dev;
+	return 0;
+}
+
+int nf_EnumDevice(mbr_drvr *driver, mbr_dev *device, int devnum)
+{
+	auto long sectors_per_track;
+	auto int tracks;
+
+	if (devnum)
+		return -EIO;
+	sectors_per_track = (long)NAND_BLOCKS * NAND_PAGES;
+	for (tracks = 1; sectors_per_track > 0xFFFFL; tracks <<= 1)
+		sectors_per_track >>= 1;
+
+	device->cylinder = tracks;
+	device->sec_track = (unsigned)sectors_per_track;
+	device->seccount = sectors_per_track * tracks;
+	device->heads = 1;
+	device->byte_sec = 512;
+	device->byte_page = NAND_PAGES * 512;
+	device->sec_block = NAND_PAGES;
+	device->driver = driver;
+	device->dev_num = devnum;
+	return 0;
+}
+
+int nf_ReadSector(unsigned long sector, char __far *buffer,
+                  char __far *spare, mbr_dev *device)
+{
+	auto nf_device * dev;
+	auto byte * page;
+
+	dev = device->driver->dev_struct;
+	if (sector >= (unsigned long)NAND_BLOCKS * NAND_PAGES)
+		return -EIO;
+	if (_nand_poll(dev))
+		return -EBUSY;
+
+	// Only the spare data is moved if there is no buffer.
+	nand_now += NAND_READ_US + (buffer ? NAND_XFER_US :
+	                            NAND_XFER_US * NAND_SPARE / NAND_PAGESIZE);
+	++dev->reads;
+	page = _nand_page(dev, sector);
+	if (buffer)
+		memcpy(buffer, page, 512);
+	if (spare)
+		memcpy(spare, page + 512, NAND_SPARE);
+
+	// The bad block marker of small block NAND
+	return page[512 + 5] == 0xFF ? 0 : -EBADBLOCK;
+}
+
+int nf_WriteSector(unsigned long sector, char __far *buffer,
+                   char __far *spare, mbr_dev *device)
+{
+	auto nf_device * dev;
+	auto byte * page;
+
+	dev = device->driver->dev_struct;
+	if (sector >= (unsigned long)NAND_BLOCKS * NAND_PAGES)
+		return -EIO;
+	if (_nand_poll(dev)) {
+		++dev->refused;
+		return -EBUSY;
+	}
+
+	nand_now += NAND_XFER_US;
+	++dev->programs;
+	page = _nand_page(dev, sector);
+	if (buffer)
+		_nand_program(dev, page, buffer, 512);
+	if (spare)
+		_nand_program(dev, page + 512, spare, NAND_SPARE);
+	dev->write_state = 1;
+	dev->busy_until = nand_now + NAND_PROG_US;
+	return -EBUSY;
+}
+
+int nf_InformStatus(mbr_dev *device, int status)
+{
+	auto _FTL_Device __far * ftl_dev;
+	auto nf_device * dev;
+	auto unsigned long block;
+
+	dev = device->driver->dev_struct;
+	if (dev->write_state)
+		return _nand_poll(dev);
+	if (status == FTLS_ERASE) {
+		ftl_dev = &ftl.dev[device->ftl_dev_idx];
+		if (ftl_dev->state == FTLS_FORMAT) {
+			// Erase the entire device, waiting for each block
+			for (block = 0; block < NAND_BLOCKS; ++block) {
+				_nand_erase(dev, block);
+				nand_now = dev->busy_until;
+			}
+			dev->write_state = 0;
+			return 0;
+		}
+		_nand_erase(dev, ftl_dev->sector / NAND_PAGES);
+		return -EBUSY;
+	}
+	return 0;
+}
+
+// ECCs are not kept (see above).
+void _nf_updateECCs(char __far *buffer, char __far *spare)
+{
+}
+
+word calculateECC8(char __far *data)
+{
+	return 0xFFFF;
+}
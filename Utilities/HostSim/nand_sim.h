@@ -0,0 +1,91 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	nand_sim.h
+
+	Simulated NAND flash device, in place of NFLASH.LIB and
+	NFLASH_FAT.LIB, for the host simulation build of FATFTL.LIB (see
+	hostftl.c).  FATFTL.LIB includes this as its _FTL_DRIVER, so it
+	declares what the FTL uses from those libraries.  The functions are
+	in nand_sim.c.
+
+	The device is a small block NAND flash, with 16 KB erase blocks of 32
+	pages, each a 512-byte sector with 16 bytes of spare data.  The
+	timings (in microseconds) are typical of such a device on a Rabbit,
+	where the CPU moves the data.
+
+***************************************************************************/
+#ifndef __NAND_SIM_H
+#define __NAND_SIM_H
+
+#ifndef NAND_BLOCKS
+	#define NAND_BLOCKS		512		// Erase blocks on the device (8 MB)
+#endif
+#define NAND_PAGES			32			// Pages (sectors) per erase block
+#define NAND_SPARE			16			// Spare bytes per page
+#define NAND_PAGESIZE		(512 + NAND_SPARE)
+
+#ifndef NAND_READ_US
+	#define NAND_READ_US		25			// Read a page into the device's buffer
+#endif
+#ifndef NAND_XFER_US
+	#define NAND_XFER_US		100		// Move a page to or from the device
+#endif
+#ifndef NAND_PROG_US
+	#define NAND_PROG_US		200		// Program a page
+#endif
+#ifndef NAND_ERASE_US
+	#define NAND_ERASE_US	2000		// Erase a block
+#endif
+#ifndef NAND_POLL_US
+	#define NAND_POLL_US		5			// Read the device's status
+#endif
+
+#define _NFLASH_MAXDEVICES	1
+
+#ifndef MBR_SIG
+	#define MBR_SIG "NFLASH-0"
+#endif
+
+typedef struct nf_device {
+	byte *			data;				// Pages, each of NAND_PAGESIZE bytes
+	int				write_state;	// Program (1) or erase (-1) in progress
+	unsigned long	busy_until;		// nand_now when it will be done
+	unsigned long	reads;			// Pages read
+	unsigned long	programs;		// Pages programmed
+	unsigned long	erases;			// Blocks erased
+	unsigned long	refused;			// Programs refused, device being busy
+	unsigned long	bad_programs;	// Programs which would set a bit to 1
+	int				mbrtype;
+	struct nf_device * next;
+} nf_device;
+
+// Simulated time in microseconds
+extern unsigned long nand_now;
+
+extern nf_device nand_dev;
+
+int nf_InitDriver(mbr_drvr *driver, void *device_list);
+int nf_EnumDevice(mbr_drvr *driver, mbr_dev *device, int devnum);
+int nf_ReadSector(unsigned long sector, char __far *buffer,
+                  char __far *spare, mbr_dev *device);
+int nf_WriteSector(unsigned long sector, char __far *buffer,
+                   char __far *spare, mbr_dev *device);
+int nf_InformStatus(mbr_dev *device, int status);
+void _nf_updateECCs(char __far *buffer, char __far *spare);
+word calculateECC8(char __far *data);
+
+#endif
@@ -0,0 +1,340 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	net_sim.c
+
+	C versions of the functions of the TCP/IP libraries which are written
+	in assembly (see SKIPFN in the Makefile), or which read their
+	variable arguments from the stack, for the host simulation build.
+	This is included after the library headers, and before their
+	bodies.  A program calls net_sim_init() before sock_init().
+
+	The packet buffers are the xmem pool of IP.LIB (_pbuf_pool), as on
+	the target, and packets are copied into them by the C versions of
+	the PKTDRV.LIB routines below.
+
+***************************************************************************/
+
+/* Stand-ins for what the libraries use from the BIOS and the standard
+   libraries */
+
+const char _hexits_upper[] = "0123456789ABCDEF";
+
+#define XMEM_AVAIL		(1L << 20)
+
+// Return the xmem available, and allocate all of it if addr is not NULL.
+long _xavail(long * addr, word align, word type)
+{
+	auto long size;
+
+	size = XMEM_AVAIL;
+	if (addr)
+		*addr = _xalloc(&size, align, type);
+	return size;
+}
+
+// Release xmem allocated by _xalloc().
+void xrelease(long addr, long size)
+{
+	free(_dcsim_ptr(addr));
+}
+
+int kbhit(void)
+{
+	return 0;
+}
+
+// Print the decimal digits of value at buf, and return the end of them.
+char * utoa(word value, char * buf)
+{
+	return buf + sprintf(buf, "%u", value);
+}
+
+// Print len bytes at p in hex.
+void mem_dump(const void __far * p, word len)
+{
+	auto word i;
+
+	for (i = 0; i < len; ++i)
+		printf(i % 16 == 15 || i == len - 1 ? "%02X\n" : "%02X ",
+			((const byte *)p)[i]);
+}
+#define xmem_dump(addr, len)	mem_dump((void __far *)(addr), len)
+
+// The packets pkt_received() looks at in one call (as in IP.LIB)
+#define IP_MAX_SNAP	2
+
+/* The packet buffer routines of PKTDRV.LIB, which take their arguments in
+   registers, so have other names here. */
+
+// Allocate a packet buffer, with its data area empty (_pb_reserve).
+static ll_prefix __far * _ns_reserve(void)
+{
+	auto long e;
+	auto ll_prefix __far * LL;
+
+	if (!(e = pxalloc(&_pbuf_pool)))
+		return NULL;
+	LL = _dcsim_ptr(e);
+	LL->ll_flags = LL->iface = 0;
+	LL->chksum_flags = 0;
+	LL->len1 = LL->len2 = LL->len3 = 0;
+	LL->data1 = LL->seg1 = (char __far *)(LL + 1);
+	LL->rlen1 = NET_BUFSIZE;
+	return LL;
+}
+
+// Append len bytes at data to the data area of LL (_pb_xmem2buf).
+static void _ns_xmem2buf(ll_prefix __far * LL, char __far * data, word len)
+{
+	memcpy(LL->seg1, data, len);
+	LL->seg1 += len;
+	LL->rlen1 -= len;
+	LL->len1 += len;
+}
+
+// Allocate a packet buffer for sending g, and copy the sections of g which
+// aren't static into it (_pb_resv_send).  As in the library, the lengths
+// of the sections of g which are left where they are become zero.
+static ll_prefix __far * _ns_resv_send(ll_Gather * g)
+{
+	auto ll_prefix __far * LL;
+
+	if (!(LL = _ns_reserve()))
+		return NULL;
+	LL->ll_flags = LL_OUTBUF;
+	LL->iface = g->iface;
+	LL->len = g->len1 + g->len2 + g->len3;
+	switch (g->flags & LLG_STAT_MASK) {
+	case LLG_STAT_DATA2 | LLG_STAT_DATA3:
+		LL->len2 = g->len2;
+		LL->data2 = g->data2;
+		g->len2 = 0;
+		// fall thru
+	case LLG_STAT_DATA3:
+		LL->len3 = g->len3;
+		LL->data3 = g->data3;
+		g->len3 = 0;
+	}
+	if (g->len1)
+		_ns_xmem2buf(LL, g->data1, g->len1);
+	if (g->len2)
+		_ns_xmem2buf(LL, g->data2, g->len2);
+	if (g->len3)
+		_ns_xmem2buf(LL, g->data3, g->len3);
+	return LL;
+}
+
+// Mark LL as a complete packet of len bytes, with a link-layer header of
+// offset bytes, and put it last in the pool's list, so that packets are
+// processed in order (_pb_finish).
+static void _ns_finish(ll_prefix __far * LL, byte iface, byte flags,
+	word offset, word len)
+{
+	LL->ll_flags = flags;
+	LL->iface = iface;
+	LL->net_offs = offset;
+	LL->seq = (word)(MS_TIMER * 32);	// the RTC's 32kHz count
+	LL->len = len;
+	pxfree(&_pbuf_pool, paddr(LL));
+	pxalloc(&_pbuf_pool);
+}
+
+/* IP.LIB */
+
+void pkt_buf_release(ll_prefix __far * LL)
+{
+	pxfree(&_pbuf_pool, paddr(LL));
+}
+
+// Store the oldest packets (up to IP_MAX_SNAP) which are ready to be
+// processed, and return the number stored.
+int16 _pkt_snapshot(ll_prefix __far ** pset)
+{
+	auto long e;
+	auto ll_prefix __far * LL;
+	auto int16 n;
+
+	for (n = 0, e = pxfirst(&_pbuf_pool); e && n < IP_MAX_SNAP;
+			e = pxnext(&_pbuf_pool, e)) {
+		LL = _dcsim_ptr(e);
+		if (LL->ll_flags && !(LL->ll_flags & (LL_OUTBUF | LL_FRAGMENT)))
+			pset[n++] = LL;
+	}
+	return n;
+}
+
+void _pkt_buf2xmem(ll_prefix __far * LL, void __far * dest, word len,
+	word offset)
+{
+	memcpy(dest, LL->data1 + offset, len);
+}
+
+// Add len bytes at data to the internet checksum sum (update_chksum).  If
+// *odd, the data before it was an odd number of bytes, so these bytes
+// are added the other way round; *odd is updated.
+static word _ns_chksum(const byte * data, word len, word sum, int16 * odd)
+{
+	auto uint32 acc;
+	auto word i;
+
+	acc = *odd ? (word)(sum << 8 | sum >> 8) : sum;
+	for (i = 0; i + 1 < len; i += 2)
+		acc += data[i] | data[i + 1] << 8;
+	if (len & 1)
+		acc += data[len - 1];
+	while (acc >> 16)
+		acc = (acc & 0xFFFF) + (acc >> 16);
+	sum = *odd ? (word)(acc << 8 | acc >> 8) : (word)acc;
+	*odd ^= len & 1;
+	return sum;
+}
+
+word fchecksum(void * data, word len)
+{
+	auto int16 odd;
+
+	odd = 0;
+	return _ns_chksum(data, len, 0, &odd);
+}
+
+word _f_checksum(char __far * buf, word len, word initial, int16 * odd)
+{
+	auto int16 o;
+
+	o = odd && *odd;
+	initial = _ns_chksum((byte *)buf, len, initial, &o);
+	if (odd)
+		*odd = -o;
+	return initial;
+}
+
+word gchecksum(ll_Gather * g, word rxpc)
+{
+	auto word sum;
+	auto int16 odd;
+
+	odd = 0;
+	sum = _ns_chksum((byte *)g->data1, g->len1, 0, &odd);
+	sum = _ns_chksum((byte *)g->data2, g->len2, sum, &odd);
+	return _ns_chksum((byte *)g->data3, g->len3, sum, &odd);
+}
+
+/* LOOPBACK.LIB */
+
+int16 loopback_ioctl(_LoopbackConfig * nic, int16 cmd, ...)
+{
+	auto va_list ap;
+	auto longword ip;
+	auto byte hix;
+	auto int16 rc;
+
+	va_start(ap, cmd);
+	rc = 0;
+	switch (cmd) {
+	case PD_HASFEATURE:
+		cmd = va_arg(ap, int);
+		rc = cmd >= PD_HASFEATURE && cmd <= PD_HAVELINK ||
+			cmd == PD_CHECKSUM_OFFLOAD || cmd == PD_MTU_BY_IPADDR;
+		break;
+	case PD_INITIALIZE:
+		rc = va_arg(ap, int);
+		rc = loopback_resetinterface(nic, rc, va_arg(ap, int));
+		break;
+	case PD_HAVELINK:
+		rc = 1;
+		break;
+	case PD_MTU_BY_IPADDR:
+#if LOOPBACK_HANDLERS
+		ip = va_arg(ap, longword);
+		hix = (byte)(ip >> 16);
+		if (IS_LOOPBACK_ADDR(ip) && hix < LOOPBACK_HANDLERS)
+			rc = nic->loh[hix].mtu;
+#endif
+		break;
+	}
+	va_end(ap);
+	return rc;
+}
+
+// Copy the packet in g to a packet buffer, ready for pkt_received(), which
+// doesn't check its checksums.
+int16 loopback_stowpacket(ll_Gather * g)
+{
+	auto int16 totlen;
+	auto ll_prefix __far * LL;
+
+	totlen = g->len1 + g->len2 + g->len3;
+	if (totlen < 1)
+		return -1;
+	g->flags &= ~LLG_STAT_MASK;
+	if (!(LL = _ns_resv_send(g)))
+		return -1;
+	_ns_finish(LL, IF_LOOPBACK, LL_READY, 0, totlen);
+	LL->chksum_flags = CHKSUM_IGNORE;
+	return 0;
+}
+
+/* NET.LIB */
+
+// The parameters are passed to vifconfig() as Dynamic C would put them on
+// the stack.  Only those which the configurations of TCP_CONFIG.LIB use
+// for the loopback interface, and the simple ones like them, are handled.
+int16 ifconfig(int16 iface, ...)
+{
+	auto va_list ap;
+	auto char buf[256], * p;
+	auto int16 ident;
+
+	va_start(ap, iface);
+	for (p = buf; ; ) {
+		if (p + sizeof(int16) + sizeof(longword) > buf + sizeof(buf))
+			exception(-ERR_BADPARAMETER);
+		*(int16 *)p = ident = va_arg(ap, int);
+		p += sizeof(int16);
+		switch (ident) {
+		case IFS_IPADDR:
+		case IFS_NETMASK:
+		case IFS_ROUTER_SET:
+		case IFS_ROUTER_ADD:
+		case IFS_NAMESERVER_SET:
+		case IFS_NAMESERVER_ADD:
+			*(longword *)p = va_arg(ap, longword);
+			p += sizeof(longword);
+			// fall thru
+		case IFS_UP:
+		case IFS_DOWN:
+			continue;
+		case IFS_END:
+			break;
+		default:
+			exception(-ERR_BADPARAMETER);
+		}
+		break;
+	}
+	va_end(ap);
+	return vifconfig(iface, buf);
+}
+
+// Do what the libraries' #GLOBAL_INITs do (other than setting things to
+// zero, as the host does), including the assembly in dcr_initdcr(), which
+// starts the local ports at a number from 1024 to 17407 taken from the
+// clock.
+void net_sim_init(void)
+{
+	dcr_initdcr();
+	next_tcp_port = next_udp_port = 1024 + (word)(MS_TIMER / 31 & 0x3FFF);
+}
@@ -0,0 +1,224 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	pool_sim.c
+
+	C versions of the functions of POOL.LIB which are written in assembly
+	(or are C wrappers around an assembly _fast routine), for the host
+	simulation build.  The rest of POOL.LIB is compiled as it is (see
+	gen/pool.c in the Makefile).
+
+	As in the library, the link fields of an element of a linked pool
+	are its next and previous pointers (root), or xmem addresses (xmem),
+	and the first two entries of the pool's link array are those of the
+	pool itself, which ends the list in both directions.  The link fields
+	are host pointers, or longs, so they take 2 * sizeof(void *) or 2 *
+	sizeof(long) bytes of each element rather than 4 or 8.
+
+***************************************************************************/
+#include <malloc.h>
+
+// pool_create() takes the pool's memory from the heap, with the arguments
+// of the memalign() of MALLOC.LIB, which are the other way round from the
+// host's.
+static void __far * _ps_memalign(long size, word alignment)
+{
+	return memalign(alignment, size);
+}
+#define memalign			_ps_memalign
+#define _sys_memalign	_ps_memalign
+
+// Link fields of the root element e (as returned by palloc): its next and
+// previous pointers, which point to the link fields of those elements.
+#define _PS_LINK(e)		((void **)(e) - 2)
+// The same for an xmem element, and a pointer to the link fields at the
+// xmem address l.
+#define _PS_XLINK(e)		((e) - 2 * sizeof(long))
+#define _PS_X(l)			((long *)_dcsim_ptr(l))
+
+static void * _ps_data(Pool_t * p, void * l)
+{
+	return l == (void *)p ? NULL : (void **)l + 2;
+}
+
+static long _ps_xdata(Pool_t * p, long l)
+{
+	return l == p->link.x[2] ? 0 : l + 2 * sizeof(long);
+}
+
+void * palloc(Pool_t * p)
+{
+	auto void ** r;
+
+	if (p->used == p->nel)
+		return NULL;
+	if (p->used >= p->hwm)
+		p->hwm = p->used + 1;
+	++p->used;
+	r = (void **)p->next.r;
+	p->next.r = *(char **)r;
+	if (!(p->flags & POOL_LINKED))
+		return r;
+	if (p->flags & POOL_AUNLK)
+		r[0] = r[1] = NULL;
+	else {
+		r[0] = p;
+		r[1] = p->link.r[1];
+		((void **)p->link.r[1])[0] = r;
+		p->link.r[1] = (char *)r;
+	}
+	return r + 2;
+}
+
+long pxalloc(Pool_t * p)
+{
+	auto long r;
+
+	if (p->used == p->nel)
+		return 0;
+	if (p->used >= p->hwm)
+		p->hwm = p->used + 1;
+	++p->used;
+	r = p->next.x;
+	p->next.x = _PS_X(r)[0];
+	if (!(p->flags & POOL_LINKED))
+		return r;
+	_PS_X(r)[0] = p->link.x[2];
+	_PS_X(r)[1] = p->link.x[1];
+	_PS_X(p->link.x[1])[0] = r;
+	p->link.x[1] = r;
+	return r + 2 * sizeof(long);
+}
+
+void pfree(Pool_t * p, void * e)
+{
+	auto void ** l;
+
+	if (p->flags & POOL_LINKED) {
+		l = _PS_LINK(e);
+		// A null next pointer means it was never put in the list.
+		if (l[0]) {
+			((void **)l[0])[1] = l[1];
+			((void **)l[1])[0] = l[0];
+		}
+		// A null previous pointer tells pmovebetween() that it is free.
+		l[1] = NULL;
+		e = l;
+	}
+	*(char **)e = p->next.r;
+	p->next.r = (char *)e;
+	--p->used;
+}
+
+void pxfree(Pool_t * p, long e)
+{
+	auto long * l;
+
+	if (p->flags & POOL_LINKED) {
+		e = _PS_XLINK(e);
+		l = _PS_X(e);
+		_PS_X(l[1])[0] = l[0];
+		_PS_X(l[0])[1] = l[1];
+	}
+	_PS_X(e)[0] = p->next.x;
+	p->next.x = e;
+	--p->used;
+}
+
+void * pfirst(Pool_t * p)
+{
+	return _ps_data(p, p->link.r[0]);
+}
+
+void * plast(Pool_t * p)
+{
+	return _ps_data(p, p->link.r[1]);
+}
+
+void * pnext(Pool_t * p, void * e)
+{
+	return e ? _ps_data(p, _PS_LINK(e)[0]) : pfirst(p);
+}
+
+void * pprev(Pool_t * p, void * e)
+{
+	return e ? _ps_data(p, _PS_LINK(e)[1]) : plast(p);
+}
+
+long pxfirst(Pool_t * p)
+{
+	return _ps_xdata(p, p->link.x[0]);
+}
+
+long pxlast(Pool_t * p)
+{
+	return _ps_xdata(p, p->link.x[1]);
+}
+
+long pxnext(Pool_t * p, long e)
+{
+	return e ? _ps_xdata(p, _PS_X(_PS_XLINK(e))[0]) : pxfirst(p);
+}
+
+long pxprev(Pool_t * p, long e)
+{
+	return e ? _ps_xdata(p, _PS_X(_PS_XLINK(e))[1]) : pxlast(p);
+}
+
+// This is the C implementation given in the library, after the debugging
+// code of pmovebetween().
+void * pmovebetween(Pool_t * p, void * e, void * d, void * f)
+{
+	auto void ** dd, ** ff, ** ddd, ** fff, ** ee;
+
+	if (!e && !(e = plast(p)))
+		return NULL;
+	ee = _PS_LINK(e);
+	dd = d ? _PS_LINK(d) : (void **)p;
+	ff = f ? _PS_LINK(f) : (void **)p;
+	if (dd[0] != (void *)ff || ff[1] != (void *)dd)
+		return NULL;
+	if (ee == dd || ee == ff)
+		return e;
+	if (fff = ee[0]) {
+		ddd = ee[1];
+		ddd[0] = fff;
+		fff[1] = ddd;
+	}
+	dd[0] = ee;
+	ff[1] = ee;
+	ee[0] = ff;
+	ee[1] = dd;
+	return e;
+}
+
+void * pputlast(Pool_t * p, void * e)
+{
+	auto void ** l;
+
+	if (!e)
+		return plast(p);
+	l = _PS_LINK(e);
+	if (l[0]) {
+		((void **)l[0])[1] = l[1];
+		((void **)l[1])[0] = l[0];
+	}
+	l[0] = p;
+	l[1] = p->link.r[1];
+	((void **)p->link.r[1])[0] = l;
+	p->link.r[1] = (char *)l;
+	return e;
+}
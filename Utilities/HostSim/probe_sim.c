@@ -0,0 +1,35 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	probe_sim.c
+
+	C version of the assembly function of PROBE.LIB, for the host
+	simulation build.  probe_now() reads the host's monotonic clock instead
+	of the real-time clock.  dcsim.h sets PROBE_TICKS to 1MHz, since the
+	host is too fast for the Rabbit's 32kHz clock to show anything.
+
+***************************************************************************/
+
+#ifdef PROBE_ENABLE
+longword probe_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (longword)(ts.tv_sec * PROBE_TICKS +
+	                  ts.tv_nsec / (1000000000 / PROBE_TICKS));
+}
+#endif
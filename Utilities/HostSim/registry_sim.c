@@ -0,0 +1,284 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	registry_sim.c
+
+	Stand-ins for what REGISTRY.LIB uses from ZSERVER.LIB, STRING.LIB and
+	CRC16.LIB, for the host simulation build.  This is included before
+	the library's header.
+
+	The Zserver resources are files held in memory (rs_files[]), which a
+	test can fill, inspect and corrupt directly.  A power failure is
+	simulated by setting rs_write_limit: once that many more bytes have
+	been written, the write in progress stops part way, and every write,
+	create and delete after it fails with -EIO, until rs_power_on().
+
+***************************************************************************/
+
+/* ZSERVER.LIB */
+
+#define SSPEC_MAXNAME	20
+
+#define O_READ				0x0001
+#define O_WRITE			0x0002
+#define O_CREAT			0x0004
+#define O_TRUNC			0x0008
+
+typedef struct ServerContext_t {
+	int		userid;
+	word		server;
+	char *	rootdir;
+	char		cwd[SSPEC_MAXNAME+1];
+	char *	dfltname;
+	void *	dirlist;
+} ServerContext;
+
+#define RS_FILES			8
+#define RS_FILESIZE		4096
+#define RS_HANDLES		8
+
+typedef struct {
+	char	name[SSPEC_MAXNAME+4];	// Empty if this file does not exist
+	long	len;
+	byte	data[RS_FILESIZE];
+} RSFile;
+
+RSFile rs_files[RS_FILES];
+
+static struct {
+	RSFile *	f;						// NULL if this handle is not open
+	long		pos;
+} _rs_handles[RS_HANDLES];
+
+// Bytes which may be written before the power fails, or -1 for no limit
+long rs_write_limit = -1;
+// Total bytes written
+long rs_written;
+static int _rs_off;
+
+// Return the file called name, or NULL if there is none.
+RSFile * rs_find(const char * name)
+{
+	auto int i;
+
+	for (i = 0; i < RS_FILES; ++i)
+		if (rs_files[i].name[0] && !strcmp(rs_files[i].name, name))
+			return rs_files + i;
+	return NULL;
+}
+
+// Create (or replace) the file called name, holding the string text.
+void rs_put(const char * name, const char * text)
+{
+	auto RSFile * f;
+	auto int i;
+
+	if (!(f = rs_find(name))) {
+		for (i = 0; rs_files[i].name[0]; ++i);
+		f = rs_files + i;
+		strcpy(f->name, name);
+	}
+	f->len = strlen(text);
+	memcpy(f->data, text, f->len);
+}
+
+// Restore the power, with no write limit.  Every handle is closed, as
+// after a reset.
+void rs_power_on(void)
+{
+	memset(_rs_handles, 0, sizeof(_rs_handles));
+	rs_write_limit = -1;
+	_rs_off = 0;
+}
+
+// Return the number of handles which are open.
+int rs_open_count(void)
+{
+	auto int i, n;
+
+	for (i = n = 0; i < RS_HANDLES; ++i)
+		n += _rs_handles[i].f != NULL;
+	return n;
+}
+
+int sspec_open(char * name, ServerContext * sctx, word flags, int node)
+{
+	auto RSFile * f;
+	auto int h, i;
+
+	for (h = 0; h < RS_HANDLES && _rs_handles[h].f; ++h);
+	if (h == RS_HANDLES)
+		return -ENFILE;
+	if (!(f = rs_find(name))) {
+		if (!(flags & O_CREAT))
+			return -ENOENT;
+		if (_rs_off)
+			return -EIO;
+		for (i = 0; i < RS_FILES && rs_files[i].name[0]; ++i);
+		if (i == RS_FILES)
+			return -ENOSPC;
+		f = rs_files + i;
+		strcpy(f->name, name);
+		f->len = 0;
+	}
+	else if (flags & O_TRUNC) {
+		if (_rs_off)
+			return -EIO;
+		f->len = 0;
+	}
+	_rs_handles[h].f = f;
+	_rs_handles[h].pos = 0;
+	return h;
+}
+
+static RSFile * _rs_file(int sspec)
+{
+	return sspec >= 0 && sspec < RS_HANDLES ? _rs_handles[sspec].f : NULL;
+}
+
+int sspec_close(int sspec)
+{
+	if (!_rs_file(sspec))
+		return -EBADF;
+	_rs_handles[sspec].f = NULL;
+	return 0;
+}
+
+int sspec_delete(char * name, ServerContext * sctx)
+{
+	auto RSFile * f;
+
+	if (!(f = rs_find(name)))
+		return -ENOENT;
+	if (_rs_off)
+		return -EIO;
+	f->name[0] = 0;
+	return 0;
+}
+
+int sspec_read(int sspec, char __far * buf, int len)
+{
+	auto RSFile * f;
+	auto long n;
+
+	if (len < 0)
+		return -EINVAL;
+	if (!(f = _rs_file(sspec)))
+		return -EBADF;
+	n = f->len - _rs_handles[sspec].pos;
+	if (!len)
+		return n > 0;
+	if (n > len)
+		n = len;
+	memcpy(buf, f->data + _rs_handles[sspec].pos, n);
+	_rs_handles[sspec].pos += n;
+	return (int)n;
+}
+
+int sspec_readchr(int sspec, char __far * buf, int len, char delim)
+{
+	auto int rc, n;
+
+	for (n = 0; n < len; ) {
+		rc = sspec_read(sspec, buf + n, 1);
+		if (rc <= 0)
+			return n ? n : rc;
+		if (buf[n++] == delim)
+			break;
+	}
+	return n;
+}
+
+int sspec_write(int sspec, char __far * buf, int len)
+{
+	auto RSFile * f;
+	auto long pos;
+	auto int n;
+
+	if (len < 0)
+		return -EINVAL;
+	if (!(f = _rs_file(sspec)))
+		return -EBADF;
+	if (_rs_off)
+		return -EIO;
+	pos = _rs_handles[sspec].pos;
+	n = len;
+	if (pos + n > RS_FILESIZE)
+		n = RS_FILESIZE - (int)pos;
+	if (rs_write_limit >= 0 && n > rs_write_limit - rs_written) {
+		n = (int)(rs_write_limit - rs_written);
+		_rs_off = 1;
+	}
+	memcpy(f->data + pos, buf, n);
+	rs_written += n;
+	_rs_handles[sspec].pos = pos += n;
+	if (pos > f->len)
+		f->len = pos;
+	if (_rs_off)
+		return -EIO;
+	return n ? n : -ENOSPC;
+}
+
+int sspec_seek(int sspec, long offset, int whence)
+{
+	auto RSFile * f;
+
+	if (!(f = _rs_file(sspec)))
+		return -EBADF;
+	if (whence == SEEK_CUR)
+		offset += _rs_handles[sspec].pos;
+	else if (whence == SEEK_END)
+		offset += f->len;
+	else if (whence != SEEK_SET)
+		return -EINVAL;
+	_rs_handles[sspec].pos = offset < 0 ? 0 : offset > f->len ? f->len : offset;
+	return 0;
+}
+
+/* STRING.LIB */
+
+word hexstr2bin(const char __far * p, char __far * bin, word bin_len)
+{
+	auto word L;
+	auto int b;
+
+	for (L = 0; L < bin_len; ++L, p += 2) {
+		if (!isxdigit(p[0]) || !isxdigit(p[1]) || sscanf(p, "%2x", &b) != 1) {
+			memset(bin + L, 0, bin_len - L);
+			return L + 1;
+		}
+		bin[L] = (char)b;
+	}
+	return 0;
+}
+
+#define _f_sscanf		sscanf
+
+/* CRC16.LIB, whose crc16_calc() is assembly.  This computes the same CRC
+   (polynomial 0x1021, not reflected) a bit at a time. */
+
+word crc16_calc(const void __far * data, word length, word current)
+{
+	auto const byte * p;
+	auto int i;
+
+	for (p = data; length--; ) {
+		current ^= *p++ << 8;
+		for (i = 0; i < 8; ++i)
+			current = current & 0x8000 ? current << 1 ^ 0x1021 : current << 1;
+	}
+	return current;
+}
@@ -0,0 +1,220 @@
+/*
+   Copyright (c) 2015, Digi International Inc.
+
+   Permission to use, copy, modify, and/or distribute this software for any
+   purpose with or without fee is hereby granted, provided that the above
+   copyright notice and this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+/***************************************************************************
+	probe2json.c
+
+	Convert a trace printed by probe_trace_print() or con_show_trace()
+	(see PROBE.LIB) to Chrome trace-event JSON, for viewing with
+	chrome://tracing or Perfetto.
+
+	Usage: probe2json [-t ticks_per_second] [input [output]]
+
+	Input and output default to stdin and stdout.  Lines which are not
+	trace events (e.g. console prompts) are ignored.  Each probe is shown
+	as a separate thread, named after the probe.  Enter/exit pairs are
+	shown as slices, and PROBE_COUNT values as a counter.
+
+	Timestamps are the low 32 bits of the Rabbit's real-time clock, so
+	they are converted relative to the earliest event, allowing for the
+	clock wrapping around (the events in a trace must be within 18 hours
+	of each other).
+
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_NAME	64
+
+typedef struct {
+	unsigned long	time;			// RTC ticks (32 bits)
+	long				offset;		// Ticks after the first event read
+	char				type;			// B, E or C
+	unsigned			value;		// For C
+	int				tid;			// Index of probe name, from 1
+	int				seq;			// Order read
+} Event;
+
+static Event * events;
+static int nevents, maxevents;
+static char (* names)[MAX_NAME];
+static int nnames;
+
+// Return the thread ID for a probe name, adding it if new.
+static int name_tid(const char * name)
+{
+	int i;
+
+	for (i = 0; i < nnames; ++i)
+		if (!strcmp(names[i], name))
+			return i + 1;
+	names = realloc(names, (nnames + 1) * sizeof(*names));
+	if (!names) {
+		perror("probe2json");
+		exit(1);
+	}
+	strcpy(names[nnames++], name);
+	return nnames;
+}
+
+// Parse "<time> <type> <name> [<value>]".  The name may contain spaces,
+// so for a counter the value is taken from the end of the line, and the
+// name is everything between the type and the value.  Returns 0 if line is
+// not an event.
+static int parse(const char * line, Event * e)
+{
+	char name[MAX_NAME];
+	char type;
+	const char * p;
+	const char * end;
+	int n;
+
+	n = 0;
+	if (sscanf(line, "%lu %c %n", &e->time, &type, &n) < 2 || !n ||
+	    !strchr("BEC", type))
+		return 0;
+	p = line + n;
+	for (end = p + strlen(p); end > p && isspace((unsigned char)end[-1]);
+	     --end);
+	e->value = 0;
+	if (type == 'C') {
+		if (end == p || !isdigit((unsigned char)end[-1]))
+			return 0;
+		while (end > p && isdigit((unsigned char)end[-1]))
+			--end;
+		e->value = (unsigned)strtoul(end, NULL, 10);
+		if (end == p || !isspace((unsigned char)end[-1]))
+			return 0;
+		while (end > p && isspace((unsigned char)end[-1]))
+			--end;
+	}
+	if (end == p)
+		return 0;
+	n = end - p < MAX_NAME ? (int)(end - p) : MAX_NAME - 1;
+	memcpy(name, p, n);
+	name[n] = 0;
+	e->time &= 0xFFFFFFFFUL;
+	e->type = type;
+	e->tid = name_tid(name);
+	return 1;
+}
+
+// Order by time, then by order read (so that an exit and enter of the
+// same probe at the same tick stay in order).
+static int compare(const void * a, const void * b)
+{
+	const Event * ea = a;
+	const Event * eb = b;
+
+	if (ea->offset != eb->offset)
+		return ea->offset < eb->offset ? -1 : 1;
+	return ea->seq < eb->seq ? -1 : ea->seq > eb->seq;
+}
+
+// Write s as the contents of a JSON string.
+static void put_string(FILE * out, const char * s)
+{
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fprintf(out, "\\%c", *s);
+		else if ((unsigned char)*s < ' ')
+			fprintf(out, "\\u%04x", (unsigned char)*s);
+		else
+			putc(*s, out);
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	FILE * in = stdin;
+	FILE * out = stdout;
+	char line[256];
+	double ticks = 32768;		// PROBE_TICKS
+	long first, min;
+	int i;
+
+	if (argc > 2 && !strcmp(argv[1], "-t")) {
+		ticks = atof(argv[2]);
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc > 3 || ticks <= 0 || argc > 1 && argv[1][0] == '-') {
+		fprintf(stderr,
+		        "Usage: probe2json [-t ticks_per_second] [input [output]]\n");
+		return 2;
+	}
+	if (argc > 1 && !(in = fopen(argv[1], "r"))) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (argc > 2 && !(out = fopen(argv[2], "w"))) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in)) {
+		if (nevents == maxevents) {
+			maxevents = maxevents ? maxevents * 2 : 256;
+			events = realloc(events, maxevents * sizeof(*events));
+			if (!events) {
+				perror("probe2json");
+				return 1;
+			}
+		}
+		if (parse(line, &events[nevents])) {
+			events[nevents].seq = nevents;
+			++nevents;
+		}
+	}
+
+	// Offsets are signed 32-bit differences, so that the clock can wrap.
+	first = nevents ? events[0].time : 0;
+	min = 0;
+	for (i = 0; i < nevents; ++i) {
+		events[i].offset = (long)(int)(unsigned)(events[i].time - first);
+		if (events[i].offset < min)
+			min = events[i].offset;
+	}
+	for (i = 0; i < nevents; ++i)
+		events[i].offset -= min;
+	qsort(events, nevents, sizeof(*events), compare);
+
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (i = 0; i < nnames; ++i) {
+		fprintf(out, "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":"
+		        "\"thread_name\",\"args\":{\"name\":\"", i + 1);
+		put_string(out, names[i]);
+		fprintf(out, "\"}},\n");
+	}
+	for (i = 0; i < nevents; ++i) {
+		fprintf(out, "{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,"
+		        "\"name\":\"", events[i].type, events[i].tid,
+		        events[i].offset * 1000000.0 / ticks);
+		put_string(out, names[events[i].tid - 1]);
+		putc('"', out);
+		if (events[i].type == 'C')
+			fprintf(out, ",\"args\":{\"value\":%u}", events[i].value);
+		fprintf(out, "}%s\n", i + 1 < nevents ? "," : "");
+	}
+	fprintf(out, "]}\n");
+
+	if (out != stdout && fclose(out)) {
+		perror(argv[2]);
+		return 1;
+	}
+	return 0;
+}